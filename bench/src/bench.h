@@ -0,0 +1,59 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "isolate.h"
+
+/*
+ * @brief Definition of a single benchmark
+ * @mem name = Name used to select the benchmark from the command line
+ * @mem run  = Function that runs the benchmark and prints its results
+ */
+
+typedef struct {
+	char* name;
+	void (*run)();
+} bench_def;
+
+/*
+ * @brief Function to get the current time in seconds
+ * @return Returns a monotonic-enough timestamp for benchmarking
+ */
+
+static f64 bench_now() {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (f64) ts.tv_sec + (f64) ts.tv_nsec / 1e9;
+}
+
+/*
+ * @brief Function to shuffle an array
+ * @param arr  = Array to shuffle
+ * @param cnt  = Length of the array
+ * @param size = Size of an element in bytes
+ */
+
+static void bench_shuffle(void* arr, size_t cnt, size_t size) {
+	u8* bytes = arr;
+	for (size_t i = cnt - 1; i > 0; i--) {
+		size_t j = ((size_t) rand() * RAND_MAX + rand()) % (i + 1);
+		for (size_t b = 0; b < size; b++) {
+			u8 tmp = bytes[i * size + b];
+			bytes[i * size + b] = bytes[j * size + b];
+			bytes[j * size + b] = tmp;
+		}
+	}
+}
+
+/*
+ * @brief Macro to print a benchmark result line
+ */
+
+#define bench_report(name, cnt, secs) \
+	printf("%-36s %10zu ops %10.3f ms %10.1f ns/op\n", name, (size_t) (cnt), (secs) * 1e3, (secs) * 1e9 / (f64) (cnt))
+
+/* Benchmarks */
+void bench_memory();
+void bench_memory_mt();
+void bench_ecs();
+
+#endif // __BENCH_H__
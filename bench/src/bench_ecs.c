@@ -0,0 +1,511 @@
+#include "bench.h"
+#include "iso_ecs/iso_ecs.h"
+#include "iso_ecs/iso_ecs_archetype.h"
+#include "iso_ecs/iso_ecs_query.h"
+#include "iso_ecs/iso_ecs_snapshot.h"
+#include "iso_ecs/iso_ecs_transform.h"
+
+typedef struct { f32 x, y, z; } bench_pos;
+typedef struct { f32 x, y, z; } bench_vel;
+typedef struct { f32* samples; } bench_owned;
+
+typedef struct {} bench_visible;
+typedef struct {} bench_enemy;
+typedef struct {} bench_static;
+typedef struct { u8 set; } bench_visible_marker;
+typedef struct { u8 set; } bench_enemy_marker;
+typedef struct { u8 set; } bench_static_marker;
+
+#define BENCH_ECS_ENTITY_CNT 100000
+#define BENCH_ECS_FRAME_CNT  100
+
+/*
+ * @brief Job of the parallel query, integrates a range of matches
+ */
+
+static void bench_ecs_integrate(iso_ecs_query* q, u32 start, u32 end, void* data) {
+	for (u32 i = start; i < end; i++) {
+		bench_pos* p = iso_ecs_query_at(q, i, 0);
+		bench_vel* v = iso_ecs_query_at(q, i, 1);
+		p->x += v->x; p->y += v->y; p->z += v->z;
+	}
+}
+
+/*
+ * @brief Integrates positions of 100k entities by looking up every component
+ *        per entity, by walking the packed records and through queries.
+ */
+
+static void bench_ecs_iterate() {
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+
+	f64 start = bench_now();
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		ents[i] = iso_entity_new(ecs);
+		iso_entity_add_component(ecs, ents[i], bench_pos, i, i, i);
+		iso_entity_add_component(ecs, ents[i], bench_vel, 1, 2, 3);
+	}
+	bench_report("create + add 2 components", BENCH_ECS_ENTITY_CNT, bench_now() - start);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+			bench_pos* p = iso_entity_get_component(ecs, ents[i], bench_pos);
+			bench_vel* v = iso_entity_get_component(ecs, ents[i], bench_vel);
+			p->x += v->x; p->y += v->y; p->z += v->z;
+		}
+	}
+	bench_report("per-entity get_component", (size_t) BENCH_ECS_ENTITY_CNT * BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		iso_comp_record* pos_rec = iso_ecs_get_record(ecs, bench_pos);
+		iso_comp_record* vel_rec = iso_ecs_get_record(ecs, bench_vel);
+		bench_pos* pos = (bench_pos*) pos_rec->data;
+		for (u32 i = 0; i < pos_rec->entry_cnt; i++) {
+			bench_vel* v = iso_comp_record_get_entry(vel_rec, pos_rec->entities[i]);
+			pos[i].x += v->x; pos[i].y += v->y; pos[i].z += v->z;
+		}
+	}
+	bench_report("record walk", (size_t) BENCH_ECS_ENTITY_CNT * BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	iso_ecs_query q = iso_ecs_query_new(ecs);
+	iso_ecs_query_with(&q, bench_pos);
+	iso_ecs_query_with(&q, bench_vel);
+
+	for (u32 cached = 0; cached < 2; cached++) {
+		iso_ecs_query_set_cached(&q, cached);
+
+		start = bench_now();
+		for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+			while (iso_ecs_query_next(&q)) {
+				bench_pos* p = q.comps[0];
+				bench_vel* v = q.comps[1];
+				p->x += v->x; p->y += v->y; p->z += v->z;
+			}
+		}
+		bench_report(cached ? "cached query" : "query", (size_t) BENCH_ECS_ENTITY_CNT * BENCH_ECS_FRAME_CNT, bench_now() - start);
+	}
+
+	// Same pass split across a worker pool
+	iso_thread_pool* pool = iso_thread_pool_new(0);
+	iso_ecs_set_thread_pool(ecs, pool);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		iso_ecs_query_parallel_for(&q, 4096, bench_ecs_integrate, NULL);
+	}
+	char name[64];
+	snprintf(name, sizeof(name), "parallel query (%u workers)", pool->thread_cnt);
+	bench_report(name, (size_t) BENCH_ECS_ENTITY_CNT * BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	iso_ecs_set_thread_pool(ecs, NULL);
+	iso_thread_pool_delete(pool);
+	iso_ecs_query_delete(&q);
+
+	start = bench_now();
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		iso_entity_delete(ecs, ents[i]);
+	}
+	bench_report("delete", BENCH_ECS_ENTITY_CNT, bench_now() - start);
+
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Same workload as bench_ecs_iterate on the archetype storage,
+ *        where the query hands out both columns of every chunk.
+ */
+
+static void bench_ecs_archetype_iterate() {
+	iso_arch_ecs* ecs = iso_arch_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+
+	f64 start = bench_now();
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		ents[i] = iso_arch_entity_new(ecs);
+		iso_arch_entity_add_component(ecs, ents[i], bench_pos, i, i, i);
+		iso_arch_entity_add_component(ecs, ents[i], bench_vel, 1, 2, 3);
+	}
+	bench_report("archetype create + add 2 components", BENCH_ECS_ENTITY_CNT, bench_now() - start);
+
+	iso_arch_query q = iso_arch_query_new(ecs);
+	iso_arch_query_with(&q, bench_pos);
+	iso_arch_query_with(&q, bench_vel);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		while (iso_arch_query_next(&q)) {
+			bench_pos* pos = iso_arch_query_column(&q, bench_pos);
+			bench_vel* vel = iso_arch_query_column(&q, bench_vel);
+			for (u32 i = 0; i < q.cnt; i++) {
+				pos[i].x += vel[i].x; pos[i].y += vel[i].y; pos[i].z += vel[i].z;
+			}
+		}
+	}
+	bench_report("archetype chunk walk", (size_t) BENCH_ECS_ENTITY_CNT * BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	start = bench_now();
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		iso_arch_entity_delete(ecs, ents[i]);
+	}
+	bench_report("archetype delete", BENCH_ECS_ENTITY_CNT, bench_now() - start);
+
+	free(ents);
+	iso_arch_ecs_delete(ecs);
+}
+
+/*
+ * @brief Creates, fills and deletes `cnt` entities one at a time and in batches
+ * @param cnt = No of entities
+ */
+
+static void bench_ecs_bulk_run(u32 cnt) {
+	iso_entity* ents = malloc(sizeof(iso_entity) * cnt);
+	bench_pos* pos = malloc(sizeof(bench_pos) * cnt);
+	for (u32 i = 0; i < cnt; i++) {
+		pos[i] = (bench_pos) { i, i, i };
+	}
+
+	char name[64];
+	iso_ecs* ecs = iso_ecs_new(cnt);
+
+	f64 start = bench_now();
+	for (u32 i = 0; i < cnt; i++) {
+		ents[i] = iso_entity_new(ecs);
+		iso_entity_add_component(ecs, ents[i], bench_pos, pos[i].x, pos[i].y, pos[i].z);
+	}
+	snprintf(name, sizeof(name), "%uk per-entity create + add", cnt / 1000);
+	bench_report(name, cnt, bench_now() - start);
+
+	start = bench_now();
+	for (u32 i = 0; i < cnt; i++) {
+		iso_entity_delete(ecs, ents[i]);
+	}
+	snprintf(name, sizeof(name), "%uk per-entity delete", cnt / 1000);
+	bench_report(name, cnt, bench_now() - start);
+
+	start = bench_now();
+	iso_entity_new_bulk(ecs, ents, cnt);
+	iso_entity_add_component_bulk(ecs, ents, cnt, bench_pos, pos);
+	snprintf(name, sizeof(name), "%uk bulk create + add", cnt / 1000);
+	bench_report(name, cnt, bench_now() - start);
+
+	start = bench_now();
+	iso_entity_delete_bulk(ecs, ents, cnt);
+	snprintf(name, sizeof(name), "%uk bulk delete", cnt / 1000);
+	bench_report(name, cnt, bench_now() - start);
+
+	iso_ecs_delete(ecs);
+	free(pos);
+	free(ents);
+}
+
+/*
+ * @brief Compares per-entity and batched structural changes at 10k, 100k and 1M entities
+ */
+
+static void bench_ecs_bulk() {
+	bench_ecs_bulk_run(10000);
+	bench_ecs_bulk_run(100000);
+	bench_ecs_bulk_run(1000000);
+}
+
+/*
+ * @brief Deletes entities that have 3 of 34 component types, where every
+ *        delete has to find the few records the entity is stored in.
+ */
+
+static void bench_ecs_sparse_types() {
+	u32 types[32];
+	for (u32 t = 0; t < 32; t++) {
+		char name[32];
+		snprintf(name, sizeof(name), "bench_filler_%u", t);
+		types[t] = __iso_ecs_register_type(name, sizeof(u32));
+	}
+
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		ents[i] = iso_entity_new(ecs);
+		iso_entity_add_component(ecs, ents[i], bench_pos, i, i, i);
+		__iso_entity_add_component(ecs, ents[i], types[i % 32], &i, sizeof(u32));
+		__iso_entity_add_component(ecs, ents[i], types[(i + 7) % 32], &i, sizeof(u32));
+	}
+
+	bench_shuffle(ents, BENCH_ECS_ENTITY_CNT, sizeof(iso_entity));
+
+	f64 start = bench_now();
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		iso_entity_delete(ecs, ents[i]);
+	}
+	bench_report("shuffled delete (3 of 34 types)", BENCH_ECS_ENTITY_CNT, bench_now() - start);
+
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Visits the positions written since the previous frame when a block of
+ *        1% of 100k entities moves every frame, against a query over every entity.
+ */
+
+static void bench_ecs_changed() {
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+	iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	iso_entity_add_component_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT, bench_pos, NULL);
+
+	iso_ecs_query all = iso_ecs_query_new(ecs);
+	iso_ecs_query_with(&all, bench_pos);
+
+	iso_ecs_query changed = iso_ecs_query_new(ecs);
+	iso_ecs_query_changed(&changed, bench_pos);
+	while (iso_ecs_query_next(&changed));
+
+	f64 full = 0, delta = 0;
+	u32 seen = 0;
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		u32 first = (f * BENCH_ECS_ENTITY_CNT / 100) % BENCH_ECS_ENTITY_CNT;
+		for (u32 i = first; i < first + BENCH_ECS_ENTITY_CNT / 100; i++) {
+			bench_pos* p = iso_entity_get_component_mut(ecs, ents[i], bench_pos);
+			p->x += 1;
+		}
+
+		f64 start = bench_now();
+		while (iso_ecs_query_next(&all)) {
+			seen += iso_ecs_query_get(&all, bench_pos)->x > 0;
+		}
+		full += bench_now() - start;
+
+		start = bench_now();
+		while (iso_ecs_query_next(&changed)) {
+			seen += iso_ecs_query_get(&changed, bench_pos)->x > 0;
+		}
+		delta += bench_now() - start;
+	}
+	bench_report("query every position", BENCH_ECS_FRAME_CNT, full);
+	bench_report("query changed positions (1%)", BENCH_ECS_FRAME_CNT, delta);
+
+	iso_entity_delete_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Saves and restores 100k entities with 2 components in memory and through a file
+ */
+
+static void bench_ecs_snapshot() {
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+	iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	iso_entity_add_component_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT, bench_pos, NULL);
+	iso_entity_add_component_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT, bench_vel, NULL);
+
+	size_t size = iso_ecs_snapshot_size(ecs);
+	void* buf = iso_alloc_aligned(size, ISO_ECS_SNAPSHOT_ALIGN);
+
+	f64 start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		iso_ecs_snapshot_write_buffer(ecs, buf);
+	}
+	bench_report("snapshot to memory", BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		iso_ecs_snapshot_load_buffer(ecs, buf, size);
+	}
+	bench_report("restore from memory", BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	start = bench_now();
+	iso_ecs_snapshot_write(ecs, "bench_ecs_snapshot.bin");
+	bench_report("snapshot to file", 1, bench_now() - start);
+
+	start = bench_now();
+	iso_ecs_snapshot_load(ecs, "bench_ecs_snapshot.bin");
+	bench_report("restore from mapped file", 1, bench_now() - start);
+	remove("bench_ecs_snapshot.bin");
+
+	iso_free_aligned(buf);
+	iso_entity_delete_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Propagates 100k transforms (1000 roots of 100 nodes) with every node,
+ *        1% of the nodes and no node changed
+ */
+
+static void bench_ecs_transform() {
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+	iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	iso_entity_add_component_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT, iso_transform, NULL);
+
+	iso_transform_tree* tree = iso_transform_tree_new(ecs);
+	srand(0);
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		u32 group = i % 100;
+		iso_entity parent = group ? ents[i - group + rand() % group] : ISO_ENTITY_NULL;
+		iso_transform_tree_add(tree, ents[i], parent);
+	}
+	iso_transform_tree_propagate(tree);
+
+	iso_ecs_query all = iso_ecs_query_new(ecs);
+	iso_ecs_query_with(&all, iso_transform);
+
+	f64 full = 0, delta = 0, clean = 0;
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		while (iso_ecs_query_next(&all)) {
+			iso_transform* t = iso_ecs_query_get_mut(&all, iso_transform);
+			t->local = iso_mat4_translate(iso_mat4_identity(), (iso_vec3) { f, 0, 0 });
+		}
+		f64 start = bench_now();
+		iso_transform_tree_propagate(tree);
+		full += bench_now() - start;
+
+		for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT / 100; i++) {
+			iso_transform* t = iso_entity_get_component_mut(ecs, ents[(u32) rand() % BENCH_ECS_ENTITY_CNT], iso_transform);
+			t->local.m[1][3] += 1;
+		}
+		start = bench_now();
+		iso_transform_tree_propagate(tree);
+		delta += bench_now() - start;
+
+		start = bench_now();
+		iso_transform_tree_propagate(tree);
+		clean += bench_now() - start;
+	}
+	bench_report("propagate every transform", BENCH_ECS_FRAME_CNT, full);
+	bench_report("propagate 1% changed transforms", BENCH_ECS_FRAME_CNT, delta);
+	bench_report("propagate unchanged transforms", BENCH_ECS_FRAME_CNT, clean);
+
+	iso_ecs_query_delete(&all);
+	iso_transform_tree_delete(tree);
+	iso_entity_delete_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Hooks of bench_owned, every component owns a small heap buffer
+ */
+
+static void bench_owned_ctor(void* comps, u32 cnt, u32 stride) {
+	for (u32 i = 0; i < cnt; i++) {
+		((bench_owned*) ((u8*) comps + (size_t) i * stride))->samples = malloc(sizeof(f32) * 4);
+	}
+}
+
+static void bench_owned_dtor(void* comps, u32 cnt, u32 stride) {
+	for (u32 i = 0; i < cnt; i++) {
+		free(((bench_owned*) ((u8*) comps + (size_t) i * stride))->samples);
+	}
+}
+
+/*
+ * @brief Constructs and destroys 100k components that own memory, one by one and in bulk
+ */
+
+static void bench_ecs_hooks() {
+	iso_ecs_set_type_hooks(bench_owned, .ctor = bench_owned_ctor, .dtor = bench_owned_dtor);
+
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+
+	f64 single = 0, bulk = 0;
+	for (u32 f = 0; f < 10; f++) {
+		iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+		f64 start = bench_now();
+		for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+			iso_entity_emplace_component(ecs, ents[i], bench_owned);
+		}
+		for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+			iso_entity_delete(ecs, ents[i]);
+		}
+		single += bench_now() - start;
+
+		iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+		start = bench_now();
+		iso_entity_add_component_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT, bench_owned, NULL);
+		iso_entity_delete_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+		bulk += bench_now() - start;
+	}
+	bench_report("owning components one by one", 10, single);
+	bench_report("owning components in bulk", 10, bulk);
+
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+/*
+ * @brief Queries 100k entities for 2 tags and without a third one (50%, 10% and 30%
+ *        of the entities), stored as tags and as 1 byte marker components
+ */
+
+static void bench_ecs_tags() {
+	iso_ecs* ecs = iso_ecs_new(BENCH_ECS_ENTITY_CNT);
+	iso_entity* ents = malloc(sizeof(iso_entity) * BENCH_ECS_ENTITY_CNT);
+	iso_entity_new_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+
+	srand(0);
+	for (u32 i = 0; i < BENCH_ECS_ENTITY_CNT; i++) {
+		u32 r = (u32) rand() % 100;
+		if (r < 50) {
+			iso_entity_add_component(ecs, ents[i], bench_visible);
+			iso_entity_add_component(ecs, ents[i], bench_visible_marker, 1);
+		}
+		if (r % 10 == 0) {
+			iso_entity_add_component(ecs, ents[i], bench_enemy);
+			iso_entity_add_component(ecs, ents[i], bench_enemy_marker, 1);
+		}
+		if (r % 10 < 3) {
+			iso_entity_add_component(ecs, ents[i], bench_static);
+			iso_entity_add_component(ecs, ents[i], bench_static_marker, 1);
+		}
+	}
+
+	iso_ecs_query tags = iso_ecs_query_new(ecs);
+	iso_ecs_query_with(&tags, bench_visible);
+	iso_ecs_query_with(&tags, bench_enemy);
+	iso_ecs_query_without(&tags, bench_static);
+
+	iso_ecs_query markers = iso_ecs_query_new(ecs);
+	iso_ecs_query_with(&markers, bench_visible_marker);
+	iso_ecs_query_with(&markers, bench_enemy_marker);
+	iso_ecs_query_without(&markers, bench_static_marker);
+
+	u64 sum = 0;
+	f64 start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		while (iso_ecs_query_next(&tags)) sum += tags.entity;
+	}
+	bench_report("query 2 tags without 1 (tags)", BENCH_ECS_FRAME_CNT, bench_now() - start);
+
+	start = bench_now();
+	for (u32 f = 0; f < BENCH_ECS_FRAME_CNT; f++) {
+		while (iso_ecs_query_next(&markers)) sum -= markers.entity;
+	}
+	bench_report("query 2 tags without 1 (markers)", BENCH_ECS_FRAME_CNT, bench_now() - start);
+	if (sum != 0) printf("Tag and marker queries disagree.\n");
+
+	iso_entity_delete_bulk(ecs, ents, BENCH_ECS_ENTITY_CNT);
+	free(ents);
+	iso_ecs_delete(ecs);
+}
+
+void bench_ecs() {
+	bench_ecs_iterate();
+	bench_ecs_archetype_iterate();
+	bench_ecs_bulk();
+	bench_ecs_sparse_types();
+	bench_ecs_changed();
+	bench_ecs_snapshot();
+	bench_ecs_transform();
+	bench_ecs_hooks();
+	bench_ecs_tags();
+}
@@ -0,0 +1,168 @@
+#include "bench.h"
+
+#define BENCH_MEMORY_BLOCK_CNT 1000000
+
+/*
+ * @brief Allocates 1M small blocks and frees them in random order.
+ *        Freeing used to be a linear search + memmove of the tracking table.
+ */
+
+static void bench_memory_random_free() {
+	size_t cnt = BENCH_MEMORY_BLOCK_CNT;
+	void** ptrs = malloc(sizeof(void*) * cnt);
+
+	f64 start = bench_now();
+	for (size_t i = 0; i < cnt; i++) {
+		ptrs[i] = iso_alloc(16 + (i & 63));
+	}
+	bench_report("iso_alloc (1M live blocks)", cnt, bench_now() - start);
+
+	bench_shuffle(ptrs, cnt, sizeof(void*));
+
+	start = bench_now();
+	for (size_t i = 0; i < cnt; i++) {
+		iso_free(ptrs[i]);
+	}
+	bench_report("iso_free (random order)", cnt, bench_now() - start);
+
+	free(ptrs);
+}
+
+#define BENCH_MEMORY_STARTUP_CNT 200000
+#define BENCH_MEMORY_WORKING_SET 4096
+#define BENCH_MEMORY_STEADY_CNT  4000000
+
+/*
+ * @brief Simulates engine startup: a burst of mixed size allocations that stay alive.
+ */
+
+static void bench_memory_startup() {
+	size_t cnt = BENCH_MEMORY_STARTUP_CNT;
+	void** ptrs = malloc(sizeof(void*) * cnt);
+
+	f64 start = bench_now();
+	for (size_t i = 0; i < cnt; i++) {
+		ptrs[i] = iso_alloc(16 << (i % 7));
+	}
+	for (size_t i = 0; i < cnt; i++) {
+		iso_free(ptrs[i]);
+	}
+	bench_report("startup iso_alloc + iso_free", cnt, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < cnt; i++) {
+		ptrs[i] = iso_alloc_uninit(16 << (i % 7));
+	}
+	for (size_t i = 0; i < cnt; i++) {
+		iso_free(ptrs[i]);
+	}
+	bench_report("startup iso_alloc_uninit + iso_free", cnt, bench_now() - start);
+
+	free(ptrs);
+}
+
+/*
+ * @brief Simulates a running game: a fixed working set where blocks are
+ *        constantly replaced by new ones of a different size.
+ */
+
+static void bench_memory_steady_state() {
+	void* slots[BENCH_MEMORY_WORKING_SET] = { 0 };
+	u32 seed = 12345;
+
+	f64 start = bench_now();
+	for (size_t i = 0; i < BENCH_MEMORY_STEADY_CNT; i++) {
+		seed = seed * 1664525 + 1013904223;
+		u32 slot = (seed >> 8) % BENCH_MEMORY_WORKING_SET;
+		iso_free(slots[slot]);
+		slots[slot] = iso_alloc(16 + (seed >> 24));
+	}
+	bench_report("steady state free + alloc", BENCH_MEMORY_STEADY_CNT, bench_now() - start);
+
+	for (size_t i = 0; i < BENCH_MEMORY_WORKING_SET; i++) {
+		iso_free(slots[i]);
+	}
+}
+
+#define BENCH_MEMORY_LIST_CNT 4000000
+
+/*
+ * @brief Grows a vertex-sized iso_list one element at a time, like a level load does.
+ */
+
+static void bench_memory_list_growth() {
+	iso_list(iso_vec3) list = NULL;
+
+	f64 start = bench_now();
+	for (size_t i = 0; i < BENCH_MEMORY_LIST_CNT; i++) {
+		iso_list_add(list, ((iso_vec3) { i, i, i }));
+	}
+	bench_report("iso_list_add (vec3, grown by realloc)", BENCH_MEMORY_LIST_CNT, bench_now() - start);
+
+	iso_list_delete(list);
+}
+
+#define BENCH_MEMORY_MT_OPS       1000000
+#define BENCH_MEMORY_MT_WORKING_SET 1024
+
+/*
+ * @brief Steady state churn run by every thread of the stress benchmark
+ * @param data = Seed of the thread
+ */
+
+static i32 bench_memory_mt_worker(void* data) {
+	void* slots[BENCH_MEMORY_MT_WORKING_SET] = { 0 };
+	u32 seed = (u32) (uintptr_t) data;
+
+	for (size_t i = 0; i < BENCH_MEMORY_MT_OPS; i++) {
+		seed = seed * 1664525 + 1013904223;
+		u32 slot = (seed >> 8) % BENCH_MEMORY_MT_WORKING_SET;
+		iso_free(slots[slot]);
+		slots[slot] = iso_alloc(16 + (seed >> 24));
+	}
+
+	for (size_t i = 0; i < BENCH_MEMORY_MT_WORKING_SET; i++) {
+		iso_free(slots[i]);
+	}
+	return 0;
+}
+
+/*
+ * @brief Runs the alloc/free churn on 1 to 16 threads at once. Every thread does
+ *        the same amount of work, so ideal scaling keeps the wall time flat.
+ */
+
+void bench_memory_mt() {
+	printf("Engine allocation mode: %s\n", iso_memory_is_tracking() ? "debug (tracked)" : "release (system allocator)");
+
+	f64 base = 0.0;
+	for (u32 thread_cnt = 1; thread_cnt <= 16; thread_cnt *= 2) {
+		SDL_Thread* threads[16];
+
+		f64 start = bench_now();
+		for (u32 i = 0; i < thread_cnt; i++) {
+			threads[i] = SDL_CreateThread(bench_memory_mt_worker, "bench_memory_mt", (void*) (uintptr_t) (i + 1));
+		}
+		for (u32 i = 0; i < thread_cnt; i++) {
+			SDL_WaitThread(threads[i], NULL);
+		}
+		f64 secs = bench_now() - start;
+
+		char name[64];
+		snprintf(name, sizeof(name), "free + alloc on %u threads", thread_cnt);
+		bench_report(name, (size_t) BENCH_MEMORY_MT_OPS * thread_cnt, secs);
+
+		// Throughput relative to a single thread
+		f64 ops_per_sec = (f64) BENCH_MEMORY_MT_OPS * thread_cnt / secs;
+		if (thread_cnt == 1) base = ops_per_sec;
+		printf("%-36s %10.2fx\n", "  scaling", ops_per_sec / base);
+	}
+}
+
+void bench_memory() {
+	printf("Engine allocation mode: %s\n", iso_memory_is_tracking() ? "debug (tracked)" : "release (system allocator)");
+	bench_memory_steady_state();
+	bench_memory_startup();
+	bench_memory_random_free();
+	bench_memory_list_growth();
+}
@@ -0,0 +1,31 @@
+#include "bench.h"
+
+static bench_def benches[] = {
+	{ "memory",    bench_memory    },
+	{ "memory_mt", bench_memory_mt },
+	{ "ecs",       bench_ecs       }
+};
+
+#define BENCH_CNT (sizeof(benches) / sizeof(benches[0]))
+
+i32 main(i32 argc, char** argv) {
+	srand(time(NULL));
+
+	// Initialize the engine memory
+	iso_memory_init();
+
+	// Runs every benchmark or only the ones named in the arguments
+	for (size_t i = 0; i < BENCH_CNT; i++) {
+		b8 selected = argc <= 1;
+		for (i32 j = 1; j < argc; j++) {
+			if (strcmp(argv[j], benches[i].name) == 0) selected = true;
+		}
+		if (!selected) continue;
+
+		printf("\n=========== %s ===========\n", benches[i].name);
+		benches[i].run();
+	}
+
+	iso_memory_alert();
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include "iso_scene/iso_scene.h"
 
 iso_app* iso_app_new(iso_app_def app_def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_APP);
 	iso_log_info("Constructing the application...\n");
 
 	iso_app* app = iso_alloc(sizeof(iso_app));
@@ -26,7 +27,14 @@ iso_app* iso_app_new(iso_app_def app_def) {
 	app->fps = 0.0f;
 	app->app_data = app_def.app_data;
 
+	// Creating the per-frame arenas
+	size_t arena_size = app_def.frame_arena_size ? app_def.frame_arena_size : ISO_FRAME_ARENA_SIZE;
+	app->frame_arenas[0] = iso_arena_new(arena_size);
+	app->frame_arenas[1] = iso_arena_new(arena_size);
+	app->frame_idx = 0;
+
 	iso_log_sucess("Created application\n");
+	iso_memory_pop_tag();
 	return app;
 }
 
@@ -38,8 +46,23 @@ void iso_app_delete(iso_app* app) {
 	iso_camera_manager_delete(app->camera_manager);
 	iso_scene_manager_delete(app->scene_manager);
 	iso_window_delete(app->window);
+	iso_arena_delete(app->frame_arenas[0]);
+	iso_arena_delete(app->frame_arenas[1]);
 
 	iso_free(app);
 
 	iso_log_sucess("Deleted application\n");
 }
+
+iso_arena* iso_app_frame_arena(iso_app* app) {
+	return app->frame_arenas[app->frame_idx];
+}
+
+iso_arena* iso_app_prev_frame_arena(iso_app* app) {
+	return app->frame_arenas[app->frame_idx ^ 1];
+}
+
+void iso_app_next_frame(iso_app* app) {
+	app->frame_idx ^= 1;
+	iso_arena_reset(app->frame_arenas[app->frame_idx]);
+}
@@ -5,6 +5,7 @@
 #include "iso_window/iso_window.h"
 #include "iso_graphics/iso_graphics.h"
 #include "iso_util/iso_memory.h"
+#include "iso_util/iso_arena.h"
 #include "iso_camera/iso_camera.h"
 #include "iso_scene/iso_scene.h"
 
@@ -23,6 +24,9 @@ typedef enum {
  * @mem graphics_def = Defination for construction of iso_graphics.
  * @mem fps          = Max fps for the app.
  * @mem app_data       = Extra memory that user can use it
+ * @mem frame_arena_size = Chunk size of the per-frame arenas (ISO_FRAME_ARENA_SIZE if 0)
+ * @mem profile_allocs    = Runs the allocation profiler and prints its report at exit (debug builds)
+ * @mem alloc_profile_csv = Path to dump the allocation profile to at exit (NULL to skip)
  */
 
 typedef struct {
@@ -30,6 +34,9 @@ typedef struct {
 	iso_graphics_def graphics_def;
 	f32 fps;
 	void* app_data;
+	size_t frame_arena_size;
+	b8    profile_allocs;
+	char* alloc_profile_csv;
 } iso_app_def;
 
 /*
@@ -40,8 +47,11 @@ typedef struct {
  * @mem scene_manager  = Pointer to the iso_scene_manager.
  * @mem fps            = Fps of the app.
  * @mem app_data       = Extra memory that user can use it
+ * @mem frame_arenas   = Double buffered arenas for per-frame allocations
+ * @mem frame_idx      = Index of the arena used by the current frame
  */
 
+#define ISO_FRAME_ARENA_SIZE (1024 * 1024)
 typedef struct{
 	iso_window*         window;
 	iso_graphics*       graphics;
@@ -50,6 +60,8 @@ typedef struct{
 	iso_app_state state;
 	f32 fps;
 	void* app_data;
+	iso_arena* frame_arenas[2];
+	u32 frame_idx;
 } iso_app;
 
 /*
@@ -67,4 +79,38 @@ ISO_API iso_app* iso_app_new(iso_app_def app_def);
 
 ISO_API void iso_app_delete(iso_app* app);
 
+/*
+ * @brief Function to get the arena of the current frame.
+ *        Everything allocated from it is released two frames later.
+ * @param app = Pointer to the iso_app.
+ * @return Returns pointer to the iso_arena.
+ */
+
+ISO_API iso_arena* iso_app_frame_arena(iso_app* app);
+
+/*
+ * @brief Function to get the arena of the previous frame.
+ *        Data built in the previous frame is still valid in this one.
+ * @param app = Pointer to the iso_app.
+ * @return Returns pointer to the iso_arena.
+ */
+
+ISO_API iso_arena* iso_app_prev_frame_arena(iso_app* app);
+
+/*
+ * @brief Function to swap the frame arenas and reset the one that becomes current.
+ *        Called by the main loop at the end of every frame.
+ * @param app = Pointer to the iso_app.
+ */
+
+ISO_API void iso_app_next_frame(iso_app* app);
+
+/*
+ * @brief Macro to allocate transient memory that lives until the end of the next frame.
+ * @param app  = Pointer to the iso_app.
+ * @param size = Size in bytes.
+ */
+
+#define iso_frame_alloc(app, size) iso_arena_alloc(iso_app_frame_arena(app), size)
+
 #endif // __ISO_APP_H__
@@ -1,15 +1,22 @@
 #include "iso_camera.h"
 
 iso_camera_manager* iso_camera_manager_new() {
+	iso_memory_push_tag(ISO_MEMORY_TAG_CAMERA);
 	iso_log_info("Constructing iso_camera_manager.\n");
 	iso_camera_manager* cm = iso_alloc(sizeof(iso_camera_manager));
+	cm->camera_pool = iso_pool_new((iso_pool_def) {
+		.name     = "iso_camera",
+		.obj_size = sizeof(iso_camera)
+	});
 	iso_log_sucess("Created iso_camera_manager.\n");
+	iso_memory_pop_tag();
 	return cm;
 }
 
 void iso_camera_manager_delete(iso_camera_manager* cm) {
 	iso_log_info("Deleting iso_camera_manager\n");
 	iso_hmap_delete(cm->cameras);
+	iso_pool_delete(cm->camera_pool);
 	iso_free(cm);
 	iso_log_sucess("Deleted iso_camera_manager\n");
 }
@@ -21,9 +28,10 @@ iso_camera* iso_camera_manager_get(iso_camera_manager* man, iso_str name) {
 }
 
 iso_camera* iso_ortho_camera_new(iso_camera_manager* cm, iso_ortho_camera_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_CAMERA);
 	iso_log_info("Constructing iso_ortho_camera\n");
 
-	iso_camera* cam = iso_alloc(sizeof(iso_camera));
+	iso_camera* cam = iso_pool_alloc(cm->camera_pool);
 
 	// Initializing camera
     iso_str tmp = iso_str_new(def.name);
@@ -45,6 +53,7 @@ iso_camera* iso_ortho_camera_new(iso_camera_manager* cm, iso_ortho_camera_def de
 	iso_hmap_add(cm->cameras, cam->name, cam);
 
 	iso_log_sucess("Created iso_ortho_camera: (Name: `%s`, Viewport: %f-%f-%f-%f-%f-%f)\n", cam->name, view.left, view.right, view.top, view.bottom, view.near, view.far);
+	iso_memory_pop_tag();
 	return cam;
 }
 
@@ -70,14 +79,15 @@ void iso_ortho_camera_delete(iso_camera_manager* cm, iso_str name) {
 	iso_assert((cam->type == ISO_ORTHOGRAPHIC_CAMERA), "Cannot delete non-orthographic camera using iso_ortho_camera_update.\n");
 
 	iso_str_delete(cam->name);
-	iso_free(cam);
+	iso_pool_free(cm->camera_pool, cam);
 	iso_log_info("Deleted iso_ortho_camera: `%s`\n", name);
 }
 
 iso_camera* iso_persp_camera_new(iso_camera_manager* cm, iso_persp_camera_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_CAMERA);
 	iso_log_info("Constructing iso_perspective_camera\n");
 
-	iso_camera* cam = iso_alloc(sizeof(iso_camera));
+	iso_camera* cam = iso_pool_alloc(cm->camera_pool);
 
 	// Initializing camera
 	iso_str tmp = iso_str_new(def.name);
@@ -99,6 +109,7 @@ iso_camera* iso_persp_camera_new(iso_camera_manager* cm, iso_persp_camera_def de
 	iso_hmap_add(cm->cameras, cam->name, cam);
 	iso_log_sucess("Created iso_perspective_camera: (Name: `%s`, Viewport: %f-%f-%f-%f)\n", cam->name, view.aspect_ratio, view.fov, view.near, view.far);
 
+	iso_memory_pop_tag();
 	return cam;
 }
 
@@ -124,6 +135,6 @@ void iso_persp_camera_delete(iso_camera_manager* cm, iso_str name) {
 	iso_assert((cam->type == ISO_PERSPECTIVE_CAMERA), "Cannot delete non-perspective camera using iso_persp_camera_delete.\n");
 
 	iso_str_delete(cam->name);
-	iso_free(cam);
+	iso_pool_free(cm->camera_pool, cam);
 	iso_log_info("Deleted iso_persp_camera: `%s`\n", name);
 }
@@ -5,6 +5,7 @@
 #include "iso_util/iso_defines.h"
 #include "iso_util/iso_hash_map.h"
 #include "iso_util/iso_str.h"
+#include "iso_util/iso_pool.h"
 #include "iso_math/iso_math.h"
 #include "iso_camera_types.h"
 
@@ -29,13 +30,14 @@ typedef struct {
 
 /*
  * @brief Struct that deals with managing and storing different cameras.
- * @mem cameras = Hashmap to store all the cameras.
- * @mem api     = Api to manage the camera
+ * @mem cameras     = Hashmap to store all the cameras.
+ * @mem camera_pool = Pool that the cameras are allocated from.
  */
 
 #define ISO_CAMERA_MEM_SIZE 99
 typedef struct {
 	iso_hmap(char*, iso_camera*, ISO_CAMERA_MEM_SIZE) cameras;
+	iso_pool* camera_pool;
 } iso_camera_manager;
 
 
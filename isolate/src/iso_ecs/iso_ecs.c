@@ -0,0 +1,71 @@
+#include "iso_ecs.h"
+
+/*
+ * @brief Component type registered in the ecs
+ * @mem name  = Name of the component
+ * @mem size  = Size of the component
+ * @mem hooks = Lifetime hooks of the component
+ */
+
+typedef struct {
+	char name[ISO_ECS_TYPE_NAME_SIZE];
+	u32  size;
+	iso_ecs_type_hooks hooks;
+} iso_ecs_type;
+
+// Registry shared by every ecs, ids are indices into it
+static iso_ecs_type __iso_ecs_types[ISO_ECS_MAX_TYPES];
+static u32          __iso_ecs_type_cnt;
+static SDL_SpinLock __iso_ecs_type_lock;
+
+u32 __iso_ecs_register_type(char* name, u32 size) {
+	iso_assert(strlen(name) < ISO_ECS_TYPE_NAME_SIZE, "Component name `%s` is too long.\n", name);
+
+	SDL_AtomicLock(&__iso_ecs_type_lock);
+
+	// Call sites of the same component share the id
+	for (u32 i = 0; i < __iso_ecs_type_cnt; i++) {
+		if (strcmp(__iso_ecs_types[i].name, name) == 0) {
+			SDL_AtomicUnlock(&__iso_ecs_type_lock);
+			iso_assert(__iso_ecs_types[i].size == size, "Component `%s` registered with a different size.\n", name);
+			return i;
+		}
+	}
+
+	iso_assert(__iso_ecs_type_cnt < ISO_ECS_MAX_TYPES, "Too many component types. Cant register `%s`.\n", name);
+
+	u32 type = __iso_ecs_type_cnt;
+	strcpy(__iso_ecs_types[type].name, name);
+	__iso_ecs_types[type].size = size;
+	__atomic_store_n(&__iso_ecs_type_cnt, type + 1, __ATOMIC_RELEASE);
+
+	SDL_AtomicUnlock(&__iso_ecs_type_lock);
+	return type;
+}
+
+char* iso_ecs_type_name(u32 type) {
+	iso_assert(type < __iso_ecs_type_cnt, "Component type `%u` is not registered.\n", type);
+	return __iso_ecs_types[type].name;
+}
+
+u32 iso_ecs_type_size(u32 type) {
+	iso_assert(type < __iso_ecs_type_cnt, "Component type `%u` is not registered.\n", type);
+	return __iso_ecs_types[type].size;
+}
+
+void __iso_ecs_set_type_hooks(u32 type, iso_ecs_type_hooks hooks) {
+	iso_assert(type < __iso_ecs_type_cnt, "Component type `%u` is not registered.\n", type);
+
+	// Tags are stored as bits, there is no component to construct or destroy
+	iso_assert(__iso_ecs_types[type].size != 0, "Component `%s` is a tag and cant have hooks.\n", __iso_ecs_types[type].name);
+	__iso_ecs_types[type].hooks = hooks;
+}
+
+iso_ecs_type_hooks* iso_ecs_get_type_hooks(u32 type) {
+	iso_assert(type < __iso_ecs_type_cnt, "Component type `%u` is not registered.\n", type);
+	return &__iso_ecs_types[type].hooks;
+}
+
+u32 iso_ecs_type_cnt() {
+	return __atomic_load_n(&__iso_ecs_type_cnt, __ATOMIC_ACQUIRE);
+}
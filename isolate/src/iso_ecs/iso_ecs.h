@@ -4,18 +4,26 @@
 #include "iso_util/iso_includes.h"
 #include "iso_util/iso_defines.h"
 #include "iso_util/iso_memory.h"
+#include "iso_util/iso_thread_pool.h"
 #include "iso_math/iso_math.h"
 
 /*
  * Table structure
- * 
+ *
  * iso_comp_table = {
- *                    iso_comp_entry
- *                         |
- *                        \/
- *	"component_1": { [ent1, comp1], [ent2, comp2], [ent3, comp3] ... }   <== iso_comp_record
- *	"component_2": { [ent1, comp1], [ent2, comp2], [ent3, comp3] ... }
+ *                   sparse          dense entities     dense data
+ *	[type_id_1]:   { [ent -> idx] }  [ent3, ent1, ...]  [comp3, comp1, ...]   <== iso_comp_record
+ *	[type_id_2]:   { [ent -> idx] }  [ent1, ent2, ...]  [comp1, comp2, ...]
  * }
+ *
+ * Type ids come from a registry shared by every ecs (see iso_ecs_type_id)
+ * The sparse index is split in pages allocated on first use, so memory follows
+ * the components that exist instead of the amount of entities times types.
+ *
+ * Components without data are tags, e.g. `typedef struct {} visible;`.
+ * Their record only keeps a bit per entity slot and no dense arrays:
+ *
+ *	[type_id_3]:   [0b0110...]                                            <== tag record
  */
 
 /* =======================
@@ -23,502 +31,2162 @@
  * ======================= */
 
 /*
- * @brief Enum to determine if the entity slot is OCCUPIED or FREE
+ * @brief Iso Entity type definition. Handle made of the index of the entity slot (low 32 bits)
+ *        and the version of the slot (high 32 bits). The version is bumped every time the slot
+ *        is freed, so handles of deleted entities never match a live entity.
  */
 
-typedef enum {
-	FREE,
-	OCCUPIED
-} iso_entity_slot_state;
+typedef u64 iso_entity;
 
+// Handle that never refers to a live entity (versions start at 1)
+#define ISO_ENTITY_NULL ((iso_entity) 0)
 
-/*
- * @brief Iso Entity type definition
- */
+static u32 iso_entity_index(iso_entity ent)   { return (u32) ent; }
+static u32 iso_entity_version(iso_entity ent) { return (u32) (ent >> 32); }
+
+static iso_entity iso_entity_make(u32 index, u32 version) {
+	return ((iso_entity) version << 32) | index;
+}
 
-typedef u32 iso_entity;
 
+// Set in the version of free slots, handles never carry it
+#define ISO_ENTITY_FREE_BIT 0x80000000u
 
-/* =======================
- * Component Entry
- * ======================= */
+
+// Initial no of slots of an entity allocator created with no capacity
+#define ISO_ENTITY_ALLOCATOR_INITIAL_CAP 64
 
 
 /*
- * @brief Component struct that stores entity id and component data
- * @mem ent  = Entity id
- * @mem data = Component data
+ * @brief Allocator of entity handles. Free slot indices are kept in a stack,
+ *        so creating and deleting an entity is O(1) and indices stay dense.
+ *        The slots double when every slot is in use.
+ * @mem entity_cnt = No of live entities
+ * @mem cap        = No of slots
+ * @mem versions   = Current version of every slot (with ISO_ENTITY_FREE_BIT if free)
+ * @mem free_ids   = Stack of free slot indices
+ * @mem free_cnt   = No of indices in `free_ids`
  */
 
 typedef struct {
-	iso_entity ent;
-	void* data;
-} iso_comp_entry;
+	u32  entity_cnt;
+	u32  cap;
+	u32* versions;
+	u32* free_ids;
+	u32  free_cnt;
+} iso_entity_allocator;
 
 
 /*
- * @brief Function to create component entry
- * @param ent  = iso_entity
- * @param data = Component data
- * @return Returns pointer to iso_comp_entry struct
+ * @brief Internal function to add slots to the allocator
+ * @param alloc = Pointer to iso_entity_allocator
+ * @param cap   = New no of slots
  */
 
-static iso_comp_entry* iso_comp_entry_new(iso_entity ent, void* data) {
-	iso_comp_entry* entry = iso_alloc(sizeof(iso_comp_entry));
-	entry->ent = ent;
-	entry->data = data;
-	return entry;
+static void __iso_entity_allocator_grow(iso_entity_allocator* alloc, u32 cap) {
+	iso_assert(cap > alloc->cap && cap <= ISO_ENTITY_FREE_BIT, "Cannot grow entity slots to `%u`.\n", cap);
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	alloc->versions = iso_realloc(alloc->versions, sizeof(u32) * cap);
+	alloc->free_ids = iso_realloc(alloc->free_ids, sizeof(u32) * cap);
+
+	// New slots go below the free ones so that the lowest indices are handed out first
+	u32 added = cap - alloc->cap;
+	memmove(alloc->free_ids + added, alloc->free_ids, sizeof(u32) * alloc->free_cnt);
+	for (u32 i = 0; i < added; i++) {
+		alloc->versions[alloc->cap + i] = 1 | ISO_ENTITY_FREE_BIT;
+		alloc->free_ids[i] = cap - 1 - i;
+	}
+	alloc->free_cnt += added;
+	alloc->cap = cap;
+	iso_memory_pop_tag();
 }
 
 
 /*
- * @brief Function to delete iso_comp_entry
- * @param entry = Pointer to iso_comp_entry struct
+ * @brief Function to create an entity allocator
+ * @param cap = Initial no of slots (more are added on demand)
+ * @return Returns the iso_entity_allocator
  */
 
-static void iso_comp_entry_delete(iso_comp_entry* entry) {
-	iso_free(entry->data);
-	iso_free(entry);
+static iso_entity_allocator iso_entity_allocator_new(u32 cap) {
+	iso_entity_allocator alloc = { 0 };
+	if (cap) __iso_entity_allocator_grow(&alloc, cap);
+	return alloc;
 }
 
 
-/* =======================
- * Component Record
- * ======================= */
+/*
+ * @brief Function to delete the entity allocator
+ * @param alloc = Pointer to iso_entity_allocator
+ */
+
+static void iso_entity_allocator_delete(iso_entity_allocator* alloc) {
+	iso_free(alloc->versions);
+	iso_free(alloc->free_ids);
+}
 
 
 /*
- * @brief Struct that holds a multiple entries of a single component type
- * @mem name          = Name of the component
- * @mem entry_cnt     = No of entry created
- * @mem max_entry_cnt = Max amount of entry that can be created
- * @mem entries       = Array of iso_comp_entry
+ * @brief Function to make sure that `cnt` entities can be created without growing
+ * @param alloc = Pointer to iso_entity_allocator
+ * @param cnt   = No of entities about to be created
  */
 
-typedef struct {
-	char* name;
-	u32   entry_cnt;
-	u32   max_entry_cnt;
-	iso_comp_entry** entries;
-} iso_comp_record;
+static void iso_entity_allocator_reserve(iso_entity_allocator* alloc, u32 cnt) {
+	if (alloc->free_cnt >= cnt) return;
+
+	u64 need = (u64) alloc->cap + cnt - alloc->free_cnt;
+	u64 cap  = alloc->cap ? alloc->cap : ISO_ENTITY_ALLOCATOR_INITIAL_CAP;
+	while (cap < need) cap *= 2;
+	if (cap > ISO_ENTITY_FREE_BIT) cap = ISO_ENTITY_FREE_BIT;
+	__iso_entity_allocator_grow(alloc, (u32) cap);
+}
 
 
 /*
- * @brief Function to create a new iso_comp_record
- * @param name          = Name of the record
- * @param max_entry_cnt = Max amount of entry to support
- * @return Returns pointer to iso_comp_record struct
+ * @brief Function to check if a handle refers to a live entity
+ * @param alloc = Pointer to iso_entity_allocator
+ * @param ent   = iso_entity handle
+ * @return Returns true if the entity is alive
  */
 
-static iso_comp_record* iso_comp_record_new(char* name, u32 max_entry_cnt) {
-	iso_comp_record* rec = iso_alloc(sizeof(iso_comp_record));
+static b8 iso_entity_allocator_alive(iso_entity_allocator* alloc, iso_entity ent) {
+	u32 idx = iso_entity_index(ent);
+	return idx < alloc->cap && alloc->versions[idx] == iso_entity_version(ent);
+}
 
-	// Initializing variables
-	rec->entries = iso_alloc(sizeof(iso_comp_entry) * max_entry_cnt);
-	rec->entry_cnt = 0;
-	rec->max_entry_cnt = max_entry_cnt;
 
-	rec->name = iso_alloc(strlen(name));
-	strcpy(rec->name, name);
+/*
+ * @brief Function to allocate a new entity handle
+ * @param alloc = Pointer to iso_entity_allocator
+ * @return Returns the iso_entity handle
+ */
 
-	return rec;
+static iso_entity iso_entity_allocator_create(iso_entity_allocator* alloc) {
+	if (alloc->free_cnt == 0) iso_entity_allocator_reserve(alloc, 1);
+
+	u32 idx = alloc->free_ids[--alloc->free_cnt];
+	alloc->entity_cnt++;
+	alloc->versions[idx] &= ~ISO_ENTITY_FREE_BIT;
+	return iso_entity_make(idx, alloc->versions[idx]);
 }
 
 
 /*
- * @brief Function to delete the iso_comp_record
- * @param rec = Pointer to iso_comp_record struct
+ * @brief Function to allocate a batch of entity handles at once
+ * @param alloc = Pointer to iso_entity_allocator
+ * @param out   = Array that receives the handles
+ * @param cnt   = No of handles to allocate
  */
 
-static void iso_comp_record_delete(iso_comp_record* rec) {
-	for (u32 i = 0; i < rec->max_entry_cnt; i++) {
-		iso_comp_entry* entry = rec->entries[i];
-		if (entry) iso_comp_entry_delete(entry);
+static void iso_entity_allocator_create_bulk(iso_entity_allocator* alloc, iso_entity* out, u32 cnt) {
+	iso_entity_allocator_reserve(alloc, cnt);
+
+	u32* ids = alloc->free_ids + alloc->free_cnt;
+	alloc->free_cnt   -= cnt;
+	alloc->entity_cnt += cnt;
+	for (u32 i = 0; i < cnt; i++) {
+		u32 idx = *--ids;
+		alloc->versions[idx] &= ~ISO_ENTITY_FREE_BIT;
+		out[i] = iso_entity_make(idx, alloc->versions[idx]);
 	}
-	iso_free(rec->name);
-	iso_free(rec->entries);
-	iso_free(rec);
 }
 
 
 /*
- * @brief Function to search an entry in record according to entity id
- * @param rec = Pointer to iso_comp_record
- * @param ent = iso_entity
- * @return Returns True if found else False
+ * @brief Function to free an entity handle. Bumps the version of the slot so the handle goes stale.
+ * @param alloc = Pointer to iso_entity_allocator
+ * @param ent   = iso_entity handle
  */
 
-static b8 iso_comp_record_search(iso_comp_record* rec, iso_entity ent) {
-	iso_assert(ent < rec->max_entry_cnt, "Tried to access entity of slot `%d` in record of max slot `%d`.\n", ent, rec->max_entry_cnt);
+static void iso_entity_allocator_destroy(iso_entity_allocator* alloc, iso_entity ent) {
+	u32 idx = iso_entity_index(ent);
 
-	iso_comp_entry* entry = rec->entries[ent];
-	if (entry) return true;
-	return false;
+	// Skipping version 0 so that ISO_ENTITY_NULL stays invalid after a wrap
+	u32 version = (alloc->versions[idx] + 1) & ~ISO_ENTITY_FREE_BIT;
+	alloc->versions[idx] = (version ? version : 1) | ISO_ENTITY_FREE_BIT;
+	alloc->free_ids[alloc->free_cnt++] = idx;
+	alloc->entity_cnt--;
 }
 
 
+/* =======================
+ * Component Types
+ * ======================= */
+
+
+// Max amount of component types that can be registered
+#define ISO_ECS_MAX_TYPES 256
+
+// Max length of the name of a component type (including the null terminator)
+#define ISO_ECS_TYPE_NAME_SIZE 64
+
+
 /*
- * @brief Function to add a new entry in the component record
- * @param rec  = Pointer to iso_comp_record
- * @param ent  = iso_entity
- * @param data = Component data
- * @return Returns pointer to iso_comp_entry struct
+ * @brief Internal function to register a component type. Registering the same name again
+ *        returns the same id, so ids agree across every translation unit using the ecs.
+ * @param name = Name of the component
+ * @param size = Size of the component
+ * @return Returns the dense type id of the component
  */
 
-static iso_comp_entry* iso_comp_record_add_entry(iso_comp_record* rec, iso_entity ent, void* data) {
-	iso_assert(ent < rec->max_entry_cnt, "Tried to access entity of slot `%d` in record of max slot `%d`.\n", ent, rec->max_entry_cnt);
-	iso_assert(rec->entry_cnt < rec->max_entry_cnt, "Component record is full. Cannot add entry to entity `%d`.\n", ent);
+ISO_API u32 __iso_ecs_register_type(char* name, u32 size);
 
-	iso_comp_entry* entry = iso_comp_entry_new(ent, data);
-	rec->entries[ent] = entry;
-	rec->entry_cnt++;
 
-	return entry;
-}
+/*
+ * @brief Function to get the name of a registered component type
+ * @param type = Type id
+ * @return Returns the name of the component
+ */
+
+ISO_API char* iso_ecs_type_name(u32 type);
 
 
 /*
- * @brief Function to get the entry from record according to the entity id
- * @param rec = Pointer to the iso_comp_record struct
- * @param ent = iso_entity
- * @return Returns pointer to iso_comp_entry struct
+ * @brief Function to get the size of a registered component type
+ * @param type = Type id
+ * @return Returns the size of the component
  */
 
-static iso_comp_entry* iso_comp_record_get_entry(iso_comp_record* rec, iso_entity ent) {
-	iso_assert(ent < rec->max_entry_cnt, "Tried to access entity of slot `%d` in record of max slot `%d`.\n", ent, rec->max_entry_cnt);
-
-	iso_comp_entry* entry = rec->entries[ent];
-	if (entry) return entry;
-	return NULL;
-}
+ISO_API u32 iso_ecs_type_size(u32 type);
 
 
 /*
- * @brief Function to remove entry from the record
- * @param rec = Pointer to the iso_comp_record
- * @param ent = iso_entity
+ * @brief Function to get the amount of registered component types
+ * @return Returns the no of types
  */
 
-static void iso_comp_record_remove_entry(iso_comp_record* rec, iso_entity ent) {
-	iso_assert(ent < rec->max_entry_cnt, "Tried to access entity of slot `%d` in record of max slot `%d`.\n", ent, rec->max_entry_cnt);
+ISO_API u32 iso_ecs_type_cnt();
 
-	iso_comp_entry* entry = rec->entries[ent];
-	iso_comp_entry_delete(entry);
 
-	rec->entries[ent] = NULL;
-	rec->entry_cnt--;
-}
+/*
+ * @brief Hooks run on a batch of `cnt` components that are `stride` bytes apart
+ *        ctor = Constructs zeroed components in place
+ *        dtor = Releases what the components own
+ *        move = Relocates components to another (non overlapping) place, `src` is dead afterwards
+ */
 
-/* =======================
- * Component Table
- * ======================= */
+typedef void (*iso_ecs_ctor_fn)(void* comps, u32 cnt, u32 stride);
+typedef void (*iso_ecs_dtor_fn)(void* comps, u32 cnt, u32 stride);
+typedef void (*iso_ecs_move_fn)(void* dst, void* src, u32 cnt, u32 stride);
 
 
 /*
- * @brief Structure to hold multiple component records
- * @mem record_cnt     = Total amount of records created
- * @mem max_record_cnt = Max amount of record that can be created
- * @mem records        = Array of iso_comp_record
+ * @brief Lifetime hooks of a component type (NULL hooks fall back to zeroing, nothing and memcpy)
+ * @mem ctor = Run by iso_entity_emplace_component and adds without data
+ * @mem dtor = Run when components are removed, their entity deleted or their ecs deleted
+ * @mem move = Run when components change slot (swap removes, compaction and growth)
  */
 
 typedef struct {
-	u32 record_cnt;
-	u32 max_record_cnt;
-	iso_comp_record** records;
-} iso_comp_table;
+	iso_ecs_ctor_fn ctor;
+	iso_ecs_dtor_fn dtor;
+	iso_ecs_move_fn move;
+} iso_ecs_type_hooks;
 
 
 /*
- * @brief Function to create new iso_comp_table
- * @param max_record_cnt = Maximum amount of record to be created
- * @return Returns pointer to iso_comp_table struct
+ * @brief Internal function to set the lifetime hooks of a component type
+ * @param type  = Type id
+ * @param hooks = Hooks of the type
  */
 
-static iso_comp_table* iso_comp_table_new(u32 max_record_cnt) {
-	iso_comp_table* table = iso_alloc(sizeof(iso_comp_table));
-	table->record_cnt = 0;
-	table->max_record_cnt = max_record_cnt;
-	table->records = iso_alloc(sizeof(iso_comp_record) * max_record_cnt);
-	return table;
-}
+ISO_API void __iso_ecs_set_type_hooks(u32 type, iso_ecs_type_hooks hooks);
 
 
 /*
- * @brief Function to delete iso_comp_table
- * @param table = Pointer to the iso_comp_table
+ * @brief Function to get the lifetime hooks of a registered component type
+ * @param type = Type id
+ * @return Returns pointer to the hooks, it stays valid for the whole run
  */
 
-static void iso_comp_table_delete(iso_comp_table* table) {
-	for (u32 i = 0; i < table->record_cnt; i++) {
-		iso_comp_record* rec = table->records[i];
-		iso_comp_record_delete(rec);
-	}
-	iso_free(table->records);
-	iso_free(table);
-}
+ISO_API iso_ecs_type_hooks* iso_ecs_get_type_hooks(u32 type);
 
 
 /*
- * @brief Function to search for component in iso_comp_table
- * @param table = Pointer to the iso_comp_table
- * @param name  = Name of the component to be searched
- * @return Returns True if found else False
+ * @brief Macro to get the type id of a component. The id is looked up on the first
+ *        use and cached in a static of the call site, afterwards it is a single load.
+ * @param comp = Component structure
  */
 
-#define iso_comp_table_search(table, comp) __iso_comp_table_search(table, #comp)
-
-static b8 __iso_comp_table_search(iso_comp_table* table, char* name) {
-	for (u32 i = 0; i < table->record_cnt; i++) {
-		iso_comp_record* rec = table->records[i];
-		if (strcmp(name, rec->name) == 0) {
-			return true;
-		}
-	}
-	return false;
-}
+#define iso_ecs_type_id(comp)                                                 \
+	({                                                                          \
+		static u32 __iso_type_id;                                                 \
+		u32 __id = __atomic_load_n(&__iso_type_id, __ATOMIC_ACQUIRE);             \
+		if (__id == 0) {                                                          \
+			__id = __iso_ecs_register_type(#comp, sizeof(comp)) + 1;                \
+			__atomic_store_n(&__iso_type_id, __id, __ATOMIC_RELEASE);               \
+		}                                                                         \
+		__id - 1;                                                                 \
+	})                                                                          \
 
 
 /*
- * @brief Function to add new component record to the table
- * @param table = Pointer to the iso_comp_table
- * @param name  = Name of the component to be added
+ * @brief Macro to set the lifetime hooks of a component, shared by every ecs.
+ *        Tags (zero-size components) cant have hooks.
+ *        Should be called before the component is added to any entity:
+ *          iso_ecs_set_type_hooks(mesh, .ctor = mesh_ctor, .dtor = mesh_dtor);
+ * @param comp = Component structure
+ * @param ...  = Fields of iso_ecs_type_hooks
  */
 
-#define iso_comp_table_add_record(table, comp) __iso_comp_table_add_record(table, #comp)
+#define iso_ecs_set_type_hooks(comp, ...)\
+	__iso_ecs_set_type_hooks(iso_ecs_type_id(comp), (iso_ecs_type_hooks) { __VA_ARGS__ })
 
-static void __iso_comp_table_add_record(iso_comp_table* table, char* name) {
-	iso_assert(table->record_cnt < table->max_record_cnt, "Component table is full. Cant create new record `%s`.\n", name);
-	table->records[table->record_cnt++] = iso_comp_record_new(name, table->max_record_cnt);
-}
+
+// No of words of an iso_ecs_mask
+#define ISO_ECS_MASK_WORDS (ISO_ECS_MAX_TYPES / 64)
 
 
 /*
- * @brief Function to get the component record from the table
- * @param table = Pointer to the iso_comp_table
- * @param name  = Name of the component to get
- * @return Returns pointer to iso_comp_record if found else NULL is returned
+ * @brief Bitset of component types
+ * @mem bits = One bit per component type id
  */
 
-#define iso_comp_table_get_record(table, comp) __iso_comp_table_get_record(table, #comp)
+typedef struct {
+	u64 bits[ISO_ECS_MASK_WORDS];
+} iso_ecs_mask;
+
+static void iso_ecs_mask_set(iso_ecs_mask* mask, u32 type)   { mask->bits[type / 64] |=  (1ull << (type % 64)); }
+static void iso_ecs_mask_clear(iso_ecs_mask* mask, u32 type) { mask->bits[type / 64] &= ~(1ull << (type % 64)); }
+static b8   iso_ecs_mask_has(iso_ecs_mask* mask, u32 type)   { return (mask->bits[type / 64] >> (type % 64)) & 1; }
 
-static iso_comp_record* __iso_comp_table_get_record(iso_comp_table* table, char* name) {
-	for (u32 i = 0; i < table->record_cnt; i++) {
-		iso_comp_record* rec = table->records[i];
-		if (strcmp(name, rec->name) == 0) {
-			return rec;
-		}
+static b8 iso_ecs_mask_eq(iso_ecs_mask* a, iso_ecs_mask* b) {
+	for (u32 i = 0; i < ISO_ECS_MASK_WORDS; i++) {
+		if (a->bits[i] != b->bits[i]) return false;
+	}
+	return true;
+}
+
+// True if `a` has every type of `b`
+static b8 iso_ecs_mask_contains(iso_ecs_mask* a, iso_ecs_mask* b) {
+	for (u32 i = 0; i < ISO_ECS_MASK_WORDS; i++) {
+		if ((a->bits[i] & b->bits[i]) != b->bits[i]) return false;
+	}
+	return true;
+}
+
+// True if `a` and `b` share a type
+static b8 iso_ecs_mask_intersects(iso_ecs_mask* a, iso_ecs_mask* b) {
+	for (u32 i = 0; i < ISO_ECS_MASK_WORDS; i++) {
+		if (a->bits[i] & b->bits[i]) return true;
+	}
+	return false;
+}
+
+// True if `sig` has every type of `with` and none of `without` (branch free so it vectorizes)
+static b8 iso_ecs_mask_match(iso_ecs_mask* sig, iso_ecs_mask* with, iso_ecs_mask* without) {
+	u64 miss = 0;
+	for (u32 i = 0; i < ISO_ECS_MASK_WORDS; i++) {
+		miss |= (with->bits[i] & ~sig->bits[i]) | (without->bits[i] & sig->bits[i]);
 	}
-	return NULL;
+	return miss == 0;
 }
 
 
 /* =======================
- * Entity Component System
+ * Component Record
  * ======================= */
 
 
+// Marks an entity that has no entry in the sparse index of a record
+#define ISO_COMP_RECORD_INVALID ((u32) -1)
+
+// Initial capacity of the dense arrays of a record
+#define ISO_COMP_RECORD_INITIAL_CAP 16
+
+// No of entity slots covered by a page of the sparse index (as a shift)
+#define ISO_COMP_RECORD_PAGE_SHIFT 12
+#define ISO_COMP_RECORD_PAGE_SIZE  (1u << ISO_COMP_RECORD_PAGE_SHIFT)
+#define ISO_COMP_RECORD_PAGE_MASK  (ISO_COMP_RECORD_PAGE_SIZE - 1)
+
+// No of dense slots summarized by an entry of the chunk ticks of a record (as a shift)
+#define ISO_COMP_RECORD_TICK_CHUNK_SHIFT 6
+#define ISO_COMP_RECORD_TICK_CHUNK       (1u << ISO_COMP_RECORD_TICK_CHUNK_SHIFT)
+
+
 /*
- * @brief Structure that holds entire component in the system
- * @mem entity_cnt     = No of entity created
- * @mem max_entity_cnt = Max no of entity that can be created
- * @mem slots          = Slots for entity (iso_entity_slot_state)
- * @mem table          = Pointer to the iso_comp_table
+ * @brief Function to compare change ticks, safe across a wrap of the tick counter
+ * @param tick  = Tick of a change
+ * @param since = Tick to compare against
+ * @return Returns true if `tick` happened after `since`
  */
 
-typedef struct {
-	u32 entity_cnt;
-	u32 max_entity_cnt;
-	iso_entity_slot_state* slots;
-	iso_comp_table* table;
-} iso_ecs;
+static b8 iso_ecs_tick_newer(u32 tick, u32 since) {
+	return (i32) (tick - since) > 0;
+}
 
 
 /*
- * @brief Function to create a new ecs
- * @param max_entity_cnt = Maximum amount of entity to be handled by ecs
- * @return Returns pointer to iso_ecs struct
+ * @brief Sparse set that holds the components of a single type.
+ *        Components are packed contiguously in `data` (in the same order as
+ *        `entities`), so iterating a component is a linear walk. Adding may
+ *        reallocate `data`, so component pointers are only valid until the next add.
+ *        The sparse index is split in pages that are only allocated once an
+ *        entity of their range gets the component.
+ *        Every slot remembers the tick it was added and last changed at, and every
+ *        ISO_COMP_RECORD_TICK_CHUNK slots share the newest change tick so that
+ *        queries looking for changes can skip untouched runs of components.
+ *        Components are constructed, relocated and destroyed through the
+ *        iso_ecs_type_hooks of their type.
+ *        Tags (zero sized components) only use `tags`, one bit per entity slot,
+ *        and have no sparse index, dense arrays or ticks.
+ * @mem name      = Name of the component
+ * @mem type      = Type id of the component
+ * @mem size      = Stride of a component in `data` (sizeof rounded up to `align`)
+ * @mem align     = Alignment of the component data (0 for the default alignment)
+ * @mem entry_cnt = No of components stored
+ * @mem cap       = Capacity of the dense arrays
+ * @mem version   = Bumped on every add, remove and reorder, used to validate cached queries
+ * @mem pages     = Pages of the sparse index: entity id to index in the dense arrays (ISO_COMP_RECORD_INVALID if absent)
+ * @mem page_cnt  = No of entries in `pages` (unallocated pages are NULL)
+ * @mem entities  = Dense array of the entities that have the component
+ * @mem data      = Dense array of the component data
+ * @mem added     = Tick every slot was added at
+ * @mem changed   = Tick every slot was last changed at
+ * @mem chunks    = Newest change tick of every chunk of slots
+ * @mem clock     = Current change tick of the table the record belongs to
+ * @mem hooks     = Lifetime hooks of the component type
+ * @mem tag       = Whether the component is a tag
+ * @mem tags      = Bit of every entity slot that has the tag
+ * @mem tag_words = No of words in `tags`
  */
 
-static iso_ecs* iso_ecs_new(u32 max_entity_cnt) {
-	iso_ecs* ecs = iso_alloc(sizeof(iso_ecs));
-	ecs->entity_cnt = 0;
-	ecs->max_entity_cnt = max_entity_cnt;
+typedef struct {
+	char* name;
+	u32   type;
+	u32   size;
+	u32   align;
+	u32   entry_cnt;
+	u32   cap;
+	u32   version;
+	u32** pages;
+	u32   page_cnt;
+	iso_entity* entities;
+	u8*   data;
+	u32*  added;
+	u32*  changed;
+	u32*  chunks;
+	u32*  clock;
+	iso_ecs_type_hooks* hooks;
+	b8    tag;
+	u64*  tags;
+	u32   tag_words;
+} iso_comp_record;
 
-	// Allocating entity slots
-	ecs->slots = iso_alloc(sizeof(iso_entity_slot_state) * max_entity_cnt);
-	memset(ecs->slots, FREE, sizeof(iso_entity_slot_state) * max_entity_cnt);
 
-	// Creating table
-	ecs->table = iso_comp_table_new(max_entity_cnt);
+/*
+ * @brief Function to create a new iso_comp_record
+ * @param type  = Type id of the component
+ * @param clock = Change tick the record stamps its slots with
+ * @return Returns pointer to iso_comp_record struct
+ */
 
-	return ecs;
+static iso_comp_record* iso_comp_record_new(u32 type, u32* clock) {
+	iso_comp_record* rec = iso_alloc(sizeof(iso_comp_record));
+
+	// Initializing variables
+	rec->name = iso_ecs_type_name(type);
+	rec->type = type;
+	rec->size = iso_ecs_type_size(type);
+	rec->align = 0;
+	rec->entry_cnt = 0;
+	rec->cap = 0;
+
+	rec->pages = NULL;
+	rec->page_cnt = 0;
+	rec->entities = NULL;
+	rec->data = NULL;
+	rec->added = NULL;
+	rec->changed = NULL;
+	rec->chunks = NULL;
+	rec->clock = clock;
+	rec->hooks = iso_ecs_get_type_hooks(type);
+	rec->tag = rec->size == 0;
+	rec->tags = NULL;
+	rec->tag_words = 0;
+
+	return rec;
 }
 
 
 /*
- * @brief Function to delete iso_ecs
- * @param ecs = Pointer to iso_ecs struct
+ * @brief Function to delete the iso_comp_record
+ * @param rec = Pointer to iso_comp_record struct
  */
 
-static void iso_ecs_delete(iso_ecs* ecs) {
-	//TODO: Fix this with proper log
-	if (ecs->entity_cnt) {
-		printf("Not all the entities are deleted.\n");
-	}
+static void iso_comp_record_delete(iso_comp_record* rec) {
+	if (rec->hooks->dtor && rec->entry_cnt) rec->hooks->dtor(rec->data, rec->entry_cnt, rec->size);
 
-	iso_comp_table_delete(ecs->table);
-	iso_free(ecs->slots);
-	iso_free(ecs);
+	for (u32 i = 0; i < rec->page_cnt; i++) {
+		iso_free(rec->pages[i]);
+	}
+	iso_free(rec->pages);
+	iso_free(rec->entities);
+	iso_free_aligned(rec->data);
+	iso_free(rec->added);
+	iso_free(rec->changed);
+	iso_free(rec->chunks);
+	iso_free(rec->tags);
+	iso_free(rec);
 }
 
 
-/* =======================
- * Entity Commands
- * ======================= */
+/*
+ * @brief Function to read the sparse index of an entity slot
+ * @param rec = Pointer to iso_comp_record
+ * @param id  = Index of the entity slot
+ * @return Returns the index in the dense arrays or ISO_COMP_RECORD_INVALID
+ */
+
+static u32 iso_comp_record_sparse_get(iso_comp_record* rec, u32 id) {
+	u32 page = id >> ISO_COMP_RECORD_PAGE_SHIFT;
+	if (page >= rec->page_cnt || rec->pages[page] == NULL) return ISO_COMP_RECORD_INVALID;
+	return rec->pages[page][id & ISO_COMP_RECORD_PAGE_MASK];
+}
 
 
 /*
- * @brief Function to create new entity
- * @param ecs = Pointer to iso_ecs
- * @return Returns a iso_entity type which is a entity id
+ * @brief Internal function to get the sparse entry of an entity slot, allocating its page if needed
+ * @param rec = Pointer to iso_comp_record
+ * @param id  = Index of the entity slot
+ * @return Returns pointer to the sparse entry
  */
 
-static iso_entity iso_entity_new(iso_ecs* ecs) {
-	iso_assert(ecs->entity_cnt < ecs->max_entity_cnt, "Entity slots are full.\n");
-	ecs->entity_cnt++;
+static u32* __iso_comp_record_sparse_slot(iso_comp_record* rec, u32 id) {
+	u32 page = id >> ISO_COMP_RECORD_PAGE_SHIFT;
+
+	if (page >= rec->page_cnt) {
+		u32 cnt = rec->page_cnt ? rec->page_cnt : 1;
+		while (cnt <= page) cnt *= 2;
+		rec->pages = iso_realloc(rec->pages, sizeof(u32*) * cnt);
+		memset(rec->pages + rec->page_cnt, 0, sizeof(u32*) * (cnt - rec->page_cnt));
+		rec->page_cnt = cnt;
+	}
 
-	// Generating random entity id
-	iso_entity id = iso_rand_range(0, ecs->max_entity_cnt);
-	do {
-		id = iso_rand_range(0, ecs->max_entity_cnt);
-	} while (ecs->slots[id] != FREE);
+	if (rec->pages[page] == NULL) {
+		rec->pages[page] = iso_alloc_uninit(sizeof(u32) * ISO_COMP_RECORD_PAGE_SIZE);
+		memset(rec->pages[page], 0xFF, sizeof(u32) * ISO_COMP_RECORD_PAGE_SIZE);
+	}
 
-	// Making the slot occupied
-	ecs->slots[id] = OCCUPIED;
-	return id;
+	return &rec->pages[page][id & ISO_COMP_RECORD_PAGE_MASK];
 }
 
 
 /*
- * @brief Function to delete an entity
- * @param ecs = Pointer to the iso_ecs
- * @param ent = iso_entity id
+ * @brief Function to set the alignment of the component data. The stride of the
+ *        components is rounded up so that every component keeps the alignment.
+ * @param rec   = Pointer to iso_comp_record
+ * @param align = Alignment in bytes (power of two)
  */
 
-static void iso_entity_delete(iso_ecs* ecs, iso_entity ent) {
-	iso_assert(ecs->slots[ent] == OCCUPIED, "Entity `%d` doesnt exists.\n", ent);
+static void iso_comp_record_set_align(iso_comp_record* rec, u32 align) {
+	iso_assert(!rec->tag, "Component `%s` is a tag and has no data to align.\n", rec->name);
+	iso_assert(rec->entry_cnt == 0, "Cannot change alignment of component `%s` after it is added to entities.\n", rec->name);
+	iso_assert(align && (align & (align - 1)) == 0, "Alignment `%u` of component `%s` is not a power of two.\n", align, rec->name);
 
-	// Searching for components that entity has
-	for (u32 i = 0; i < ecs->table->record_cnt; i++) {
-		iso_comp_record* rec = ecs->table->records[i];
-		if (iso_comp_record_search(rec, ent)) {
-			iso_comp_record_remove_entry(rec, ent);
-		}
-	}
+	rec->align = align;
+	rec->size  = (rec->size + align - 1) & ~(align - 1);
+}
 
-	// Reseting the slot
-	ecs->slots[ent] = FREE;
-	ecs->entity_cnt--;
+
+/*
+ * @brief Function to search an entry in record according to entity id
+ * @param rec = Pointer to iso_comp_record
+ * @param ent = iso_entity
+ * @return Returns True if found else False
+ */
+
+static b8 iso_comp_record_search(iso_comp_record* rec, iso_entity ent) {
+	u32 id = iso_entity_index(ent);
+	if (rec->tag) return (id >> 6) < rec->tag_words && (rec->tags[id >> 6] >> (id & 63)) & 1;
+	return iso_comp_record_sparse_get(rec, id) != ISO_COMP_RECORD_INVALID;
 }
 
 
 /*
- * @brief Internal function to add component to entity
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param name = Name of the component
- * @param data = Data of the component
+ * @brief Internal function to set the bit of an entity in a tag record
+ * @param rec = Pointer to iso_comp_record
+ * @param ent = iso_entity
  */
 
-static void* __iso_entity_add_component(iso_ecs* ecs, iso_entity ent, char* name, void* data) {
-	iso_assert(ecs->slots[ent] == OCCUPIED, "Entity `%d` doesnt exists.\n", ent);
+static void __iso_comp_record_set_tag(iso_comp_record* rec, iso_entity ent) {
+	u32 id = iso_entity_index(ent);
+	iso_assert(!iso_comp_record_search(rec, ent), "Entity `%u` already has component `%s`.\n", id, rec->name);
 
-	if (!__iso_comp_table_search(ecs->table, name)) {
-		__iso_comp_table_add_record(ecs->table, name);
+	if ((id >> 6) >= rec->tag_words) {
+		u32 words = rec->tag_words ? rec->tag_words : 1;
+		while (words <= (id >> 6)) words *= 2;
+		rec->tags = iso_realloc(rec->tags, sizeof(u64) * words);
+		memset(rec->tags + rec->tag_words, 0, sizeof(u64) * (words - rec->tag_words));
+		rec->tag_words = words;
 	}
 
-	iso_comp_record* rec  = __iso_comp_table_get_record(ecs->table, name);
-	iso_comp_entry* entry = iso_comp_record_add_entry(rec, ent, data);
-
-	iso_assert(entry, "Failed to add component `%s` in entity `%d`.\n", name, ent);
-	return entry->data;
+	rec->tags[id >> 6] |= 1ull << (id & 63);
+	rec->entry_cnt++;
 }
 
 
 /*
- * @brief Internal function to get the component from entity
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param name = Name of the component
- * @return Returns pointer to the component data
+ * @brief Internal function to clear the bit of an entity in a tag record
+ * @param rec = Pointer to iso_comp_record
+ * @param ent = iso_entity that has the tag
  */
 
-static void* __iso_entity_get_component(iso_ecs* ecs, iso_entity ent, char* name) {
-	iso_assert(__iso_comp_table_search(ecs->table, name), "Component `%s` is not in component table.\n", name);
+static void __iso_comp_record_clear_tag(iso_comp_record* rec, iso_entity ent) {
+	u32 id = iso_entity_index(ent);
+	rec->tags[id >> 6] &= ~(1ull << (id & 63));
+	rec->entry_cnt--;
+}
 
-	iso_comp_record* rec = __iso_comp_table_get_record(ecs->table, name);
-	iso_assert(iso_comp_record_search(rec, ent), "Entity `%d` doesnt have component `%s`.\n", ent, name);
 
-	iso_comp_entry* entry = iso_comp_record_get_entry(rec, ent);
-	iso_assert(entry, "Entity `%d` doesnt have component `%s`\n", ent, name);
+/*
+ * @brief Function to make room for at least `cap` components in the dense arrays
+ * @param rec = Pointer to iso_comp_record
+ * @param cap = Required capacity
+ */
 
-	return entry->data;
+static void iso_comp_record_reserve(iso_comp_record* rec, u32 cap) {
+	if (cap <= rec->cap || rec->tag) return;
+
+	u32 old_chunks = (rec->cap + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT;
+	u32 new_chunks = (cap + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT;
+	rec->cap = cap;
+
+	u32 align = rec->align > ISO_CACHE_LINE_SIZE ? rec->align : ISO_CACHE_LINE_SIZE;
+	rec->entities = iso_realloc(rec->entities, sizeof(iso_entity) * rec->cap);
+	if (rec->hooks->move && rec->entry_cnt) {
+		// Components that cant be copied bitwise are moved into the new block
+		u8* data = iso_alloc_aligned((size_t) rec->size * rec->cap, align);
+		rec->hooks->move(data, rec->data, rec->entry_cnt, rec->size);
+		iso_free_aligned(rec->data);
+		rec->data = data;
+	} else {
+		rec->data = iso_realloc_aligned(rec->data, (size_t) rec->size * rec->cap, align);
+	}
+	rec->added    = iso_realloc(rec->added, sizeof(u32) * rec->cap);
+	rec->changed  = iso_realloc(rec->changed, sizeof(u32) * rec->cap);
+	rec->chunks   = iso_realloc(rec->chunks, sizeof(u32) * new_chunks);
+	memset(rec->chunks + old_chunks, 0, sizeof(u32) * (new_chunks - old_chunks));
 }
 
 
 /*
- * @brief Internal function to remove component from entity
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param name = Name of the component
+ * @brief Function to stamp a slot as changed at the current tick
+ * @param rec = Pointer to iso_comp_record
+ * @param idx = Index of the slot in the dense arrays
  */
 
-static void __iso_entity_remove_component(iso_ecs* ecs, iso_entity ent, char* name) {
-	iso_assert(__iso_comp_table_search(ecs->table, name), "Component `%s` is not in table.\n", name);
-
-	iso_comp_record* rec = __iso_comp_table_get_record(ecs->table, name);
-	iso_assert(iso_comp_record_search(rec, ent), "Entity `%d` doesnt have component `%s`.\n", ent, name);
+static void iso_comp_record_mark_changed(iso_comp_record* rec, u32 idx) {
+	u32 tick = __atomic_load_n(rec->clock, __ATOMIC_RELAXED);
+	rec->changed[idx] = tick;
 
-	iso_comp_record_remove_entry(rec, ent);
+	// Slots of a chunk can be written by different threads of a parallel query
+	u32* chunk = &rec->chunks[idx >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT];
+	if (__atomic_load_n(chunk, __ATOMIC_RELAXED) != tick) {
+		__atomic_store_n(chunk, tick, __ATOMIC_RELAXED);
+	}
 }
 
 
 /*
- * @brief Macro to add a new component
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param comp = Component structure
- * @param ...  = Component parameters
+ * @brief Internal function to move the ticks of a slot into another slot
+ * @param rec = Pointer to iso_comp_record
+ * @param dst = Index of the destination slot
+ * @param src = Index of the source slot
  */
 
-#define iso_entity_add_component(ecs, ent, comp, ...)   \
-	({                                                    \
-		comp c = { __VA_ARGS__ };                           \
-		comp* cp = iso_alloc(sizeof(c));                    \
-		memcpy(cp, &c, sizeof(c));                          \
-		__iso_entity_add_component(ecs, ent, #comp, cp);    \
-	})                                                    \
+static void __iso_comp_record_move_ticks(iso_comp_record* rec, u32 dst, u32 src) {
+	rec->added[dst]   = rec->added[src];
+	rec->changed[dst] = rec->changed[src];
+
+	// Chunk ticks only grow, they are a bound used to skip chunks
+	u32* chunk = &rec->chunks[dst >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT];
+	if (iso_ecs_tick_newer(rec->changed[dst], *chunk)) *chunk = rec->changed[dst];
+}
 
 
 /*
- * @brief Macro to get a component
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param comp = Component structure
+ * @brief Internal function to move the component of a slot into another slot
+ * @param rec = Pointer to iso_comp_record
+ * @param dst = Index of the destination slot
+ * @param src = Index of the source slot
  */
 
-#define iso_entity_get_component(ecs, ent, comp)\
-	__iso_entity_get_component(ecs, ent, #comp)
+static void __iso_comp_record_move_data(iso_comp_record* rec, u32 dst, u32 src) {
+	u8* to   = rec->data + (size_t) dst * rec->size;
+	u8* from = rec->data + (size_t) src * rec->size;
+	if (rec->hooks->move) rec->hooks->move(to, from, 1, rec->size);
+	else                  memcpy(to, from, rec->size);
+}
 
 
 /*
- * @brief Macro to remove a component
- * @param ecs  = Pointer to iso_ecs
- * @param ent  = iso_entity id
- * @param comp = Component structure
+ * @brief Function to grow the dense arrays of the record
+ * @param rec = Pointer to iso_comp_record
  */
 
-#define iso_entity_remove_component(ecs, ent, comp)\
-	__iso_entity_remove_component(ecs, ent, #comp)
+static void __iso_comp_record_grow(iso_comp_record* rec) {
+	iso_comp_record_reserve(rec, rec->cap ? rec->cap * 2 : ISO_COMP_RECORD_INITIAL_CAP);
+}
+
+
+/*
+ * @brief Internal function to add a slot for an entity without initializing its data
+ * @param rec = Pointer to iso_comp_record
+ * @param ent = iso_entity
+ * @return Returns pointer to the uninitialized component data inside the record (NULL for tags)
+ */
+
+static void* __iso_comp_record_push(iso_comp_record* rec, iso_entity ent) {
+	if (rec->tag) {
+		__iso_comp_record_set_tag(rec, ent);
+		rec->version++;
+		return NULL;
+	}
+
+	u32 id = iso_entity_index(ent);
+	u32* sparse = __iso_comp_record_sparse_slot(rec, id);
+	iso_assert(*sparse == ISO_COMP_RECORD_INVALID, "Entity `%u` already has component `%s`.\n", id, rec->name);
+
+	if (rec->entry_cnt == rec->cap) __iso_comp_record_grow(rec);
+
+	u32 idx = rec->entry_cnt++;
+	rec->version++;
+	*sparse = idx;
+	rec->entities[idx] = ent;
+	iso_comp_record_mark_changed(rec, idx);
+	rec->added[idx] = rec->changed[idx];
+
+	return rec->data + (size_t) idx * rec->size;
+}
+
+
+/*
+ * @brief Function to add a new entry in the component record
+ * @param rec  = Pointer to iso_comp_record
+ * @param ent  = iso_entity
+ * @param data = Component data copied into the record (NULL constructs it in place)
+ * @return Returns pointer to the component data inside the record
+ */
+
+static void* iso_comp_record_add_entry(iso_comp_record* rec, iso_entity ent, void* data) {
+	void* slot = __iso_comp_record_push(rec, ent);
+	if (rec->tag) {
+		return NULL;
+	} else if (data) {
+		memcpy(slot, data, rec->size);
+	} else {
+		memset(slot, 0, rec->size);
+		if (rec->hooks->ctor) rec->hooks->ctor(slot, 1, rec->size);
+	}
+	return slot;
+}
+
+
+/*
+ * @brief Function to add entries for a batch of entities. The dense arrays are grown
+ *        once and the component data is copied in a single block when the strides match.
+ * @param rec    = Pointer to iso_comp_record
+ * @param ents   = Array of entities that dont have the component yet
+ * @param cnt    = No of entities
+ * @param data   = Array of `cnt` components copied into the record (NULL constructs them in place)
+ * @param stride = Distance in bytes between the components of `data`
+ * @return Returns pointer to the data of the first added component (NULL if `cnt` is 0 or for tags)
+ */
+
+static void* iso_comp_record_add_entries(iso_comp_record* rec, iso_entity* ents, u32 cnt, void* data, u32 stride) {
+	if (cnt == 0) return NULL;
+
+	if (rec->tag) {
+		for (u32 i = 0; i < cnt; i++) {
+			__iso_comp_record_set_tag(rec, ents[i]);
+		}
+		rec->version++;
+		return NULL;
+	}
+
+	if (rec->entry_cnt + cnt > rec->cap) {
+		u32 cap = rec->cap ? rec->cap : ISO_COMP_RECORD_INITIAL_CAP;
+		while (cap < rec->entry_cnt + cnt) cap *= 2;
+		iso_comp_record_reserve(rec, cap);
+	}
+
+	u32 first = rec->entry_cnt;
+	for (u32 i = 0; i < cnt; i++) {
+		u32 id = iso_entity_index(ents[i]);
+		u32* sparse = __iso_comp_record_sparse_slot(rec, id);
+		iso_assert(*sparse == ISO_COMP_RECORD_INVALID, "Entity `%u` already has component `%s`.\n", id, rec->name);
+		*sparse = first + i;
+	}
+	memcpy(rec->entities + first, ents, sizeof(iso_entity) * cnt);
+
+	u32 tick = __atomic_load_n(rec->clock, __ATOMIC_RELAXED);
+	for (u32 i = first; i < first + cnt; i++) {
+		rec->added[i] = rec->changed[i] = tick;
+	}
+	for (u32 c = first >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT; c <= (first + cnt - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT; c++) {
+		rec->chunks[c] = tick;
+	}
+
+	u8* slot = rec->data + (size_t) first * rec->size;
+	if (data == NULL) {
+		memset(slot, 0, (size_t) rec->size * cnt);
+		if (rec->hooks->ctor) rec->hooks->ctor(slot, cnt, rec->size);
+	} else if (stride == rec->size) {
+		memcpy(slot, data, (size_t) rec->size * cnt);
+	} else {
+		memset(slot, 0, (size_t) rec->size * cnt);
+		for (u32 i = 0; i < cnt; i++) {
+			memcpy(slot + (size_t) i * rec->size, (u8*) data + (size_t) i * stride, stride);
+		}
+	}
+
+	rec->entry_cnt += cnt;
+	rec->version++;
+	return slot;
+}
+
+
+/*
+ * @brief Function to get the entry from record according to the entity id
+ * @param rec = Pointer to the iso_comp_record struct
+ * @param ent = iso_entity
+ * @return Returns pointer to the component data or NULL if the entity doesnt have it (always NULL for tags)
+ */
+
+static void* iso_comp_record_get_entry(iso_comp_record* rec, iso_entity ent) {
+	if (rec->tag) return NULL;
+	u32 idx = iso_comp_record_sparse_get(rec, iso_entity_index(ent));
+	if (idx == ISO_COMP_RECORD_INVALID) return NULL;
+	return rec->data + (size_t) idx * rec->size;
+}
+
+
+/*
+ * @brief Function to remove entry from the record.
+ *        The last entry is moved into the freed slot to keep the arrays packed.
+ * @param rec = Pointer to the iso_comp_record
+ * @param ent = iso_entity
+ */
+
+static void iso_comp_record_remove_entry(iso_comp_record* rec, iso_entity ent) {
+	if (rec->tag) {
+		__iso_comp_record_clear_tag(rec, ent);
+		rec->version++;
+		return;
+	}
+
+	u32* sparse = __iso_comp_record_sparse_slot(rec, iso_entity_index(ent));
+
+	u32 idx  = *sparse;
+	u32 last = --rec->entry_cnt;
+	rec->version++;
+
+	if (rec->hooks->dtor) rec->hooks->dtor(rec->data + (size_t) idx * rec->size, 1, rec->size);
+
+	if (idx != last) {
+		iso_entity moved = rec->entities[last];
+		rec->entities[idx] = moved;
+		*__iso_comp_record_sparse_slot(rec, iso_entity_index(moved)) = idx;
+		__iso_comp_record_move_data(rec, idx, last);
+		__iso_comp_record_move_ticks(rec, idx, last);
+	}
+	*sparse = ISO_COMP_RECORD_INVALID;
+}
+
+
+/*
+ * @brief Function to remove the entries of a batch of entities. Large batches are
+ *        dropped by compacting the dense arrays once instead of swapping per entry,
+ *        which also keeps the remaining components in order and runs the destructor
+ *        once per run of removed components.
+ * @param rec  = Pointer to the iso_comp_record
+ * @param ents = Array of entities (entities without the component are skipped)
+ * @param cnt  = No of entities
+ */
+
+static void iso_comp_record_remove_entries(iso_comp_record* rec, iso_entity* ents, u32 cnt) {
+	if (rec->entry_cnt == 0) return;
+
+	if (rec->tag) {
+		for (u32 i = 0; i < cnt; i++) {
+			if (iso_comp_record_search(rec, ents[i])) __iso_comp_record_clear_tag(rec, ents[i]);
+		}
+		rec->version++;
+		return;
+	}
+
+	// Small batches are cheaper to swap out one by one
+	if ((u64) cnt * 4 < rec->entry_cnt) {
+		for (u32 i = 0; i < cnt; i++) {
+			if (iso_comp_record_search(rec, ents[i])) {
+				iso_comp_record_remove_entry(rec, ents[i]);
+			}
+		}
+		return;
+	}
+
+	u32 hole = rec->entry_cnt;
+	for (u32 i = 0; i < cnt; i++) {
+		u32 id = iso_entity_index(ents[i]);
+		u32 idx = iso_comp_record_sparse_get(rec, id);
+		if (idx == ISO_COMP_RECORD_INVALID) continue;
+		if (idx < hole) hole = idx;
+		*__iso_comp_record_sparse_slot(rec, id) = ISO_COMP_RECORD_INVALID;
+	}
+	if (hole == rec->entry_cnt) return;
+
+	// Sliding the kept entries down over the holes, destroying the removed ones run by run
+	u32 w = hole, dead = hole;
+	for (u32 r = hole; r < rec->entry_cnt; r++) {
+		u32* sparse = __iso_comp_record_sparse_slot(rec, iso_entity_index(rec->entities[r]));
+		if (*sparse == ISO_COMP_RECORD_INVALID) continue;
+
+		if (rec->hooks->dtor && r > dead) rec->hooks->dtor(rec->data + (size_t) dead * rec->size, r - dead, rec->size);
+		dead = r + 1;
+
+		*sparse = w;
+		rec->entities[w] = rec->entities[r];
+		if (w != r) __iso_comp_record_move_data(rec, w, r);
+		__iso_comp_record_move_ticks(rec, w, r);
+		w++;
+	}
+	if (rec->hooks->dtor && rec->entry_cnt > dead) {
+		rec->hooks->dtor(rec->data + (size_t) dead * rec->size, rec->entry_cnt - dead, rec->size);
+	}
+	rec->entry_cnt = w;
+	rec->version++;
+}
+
+/*
+ * @brief Function to remove every entry of the record while keeping its storage
+ * @param rec = Pointer to the iso_comp_record
+ */
+
+static void iso_comp_record_clear(iso_comp_record* rec) {
+	if (rec->hooks->dtor && rec->entry_cnt) rec->hooks->dtor(rec->data, rec->entry_cnt, rec->size);
+
+	for (u32 i = 0; i < rec->page_cnt; i++) {
+		if (rec->pages[i]) memset(rec->pages[i], 0xFF, sizeof(u32) * ISO_COMP_RECORD_PAGE_SIZE);
+	}
+	if (rec->chunks) {
+		memset(rec->chunks, 0, sizeof(u32) * ((rec->cap + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT));
+	}
+	if (rec->tags) memset(rec->tags, 0, sizeof(u64) * rec->tag_words);
+	rec->entry_cnt = 0;
+	rec->version++;
+}
+
+/*
+ * @brief Function to move the components of a list of entity slots to the front of the
+ *        record, in the order of the list, so that walking them is a linear walk of the
+ *        dense arrays. Rows of the other components change, like after a remove.
+ * @param rec = Pointer to the iso_comp_record
+ * @param ids = Entity slot indices, every one of them must have the component
+ * @param cnt = No of slots
+ */
+
+static void iso_comp_record_reorder(iso_comp_record* rec, u32* ids, u32 cnt) {
+	iso_assert(!rec->tag, "Component `%s` is a tag and has no rows to reorder.\n", rec->name);
+
+	u8* tmp = NULL;
+	for (u32 p = 0; p < cnt; p++) {
+		u32 cur = iso_comp_record_sparse_get(rec, ids[p]);
+		iso_assert(cur != ISO_COMP_RECORD_INVALID && cur >= p, "Entity `%u` doesnt have component `%s` or is listed twice.\n", ids[p], rec->name);
+		if (cur == p) continue;
+
+		// Swapping the row of the slot with the row at `p`
+		if (tmp == NULL) tmp = iso_alloc_uninit(rec->size);
+		u8* a = rec->data + (size_t) p * rec->size;
+		u8* b = rec->data + (size_t) cur * rec->size;
+		if (rec->hooks->move) {
+			rec->hooks->move(tmp, a, 1, rec->size);
+			rec->hooks->move(a, b, 1, rec->size);
+			rec->hooks->move(b, tmp, 1, rec->size);
+		} else {
+			memcpy(tmp, a, rec->size);
+			memcpy(a, b, rec->size);
+			memcpy(b, tmp, rec->size);
+		}
+
+		iso_entity ent = rec->entities[p];
+		rec->entities[p]   = rec->entities[cur];
+		rec->entities[cur] = ent;
+		*__iso_comp_record_sparse_slot(rec, iso_entity_index(ent)) = cur;
+		*__iso_comp_record_sparse_slot(rec, ids[p]) = p;
+
+		u32 added   = rec->added[p];
+		u32 changed = rec->changed[p];
+		__iso_comp_record_move_ticks(rec, p, cur);
+		rec->added[cur]   = added;
+		rec->changed[cur] = changed;
+		u32* chunk = &rec->chunks[cur >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT];
+		if (iso_ecs_tick_newer(changed, *chunk)) *chunk = changed;
+	}
+
+	if (tmp) {
+		iso_free(tmp);
+		rec->version++;
+	}
+}
+
+/* =======================
+ * Component Table
+ * ======================= */
+
+
+/*
+ * @brief Structure to hold multiple component records
+ * @mem record_cnt     = Total amount of records created
+ * @mem record_types   = Type ids of the created records in creation order
+ * @mem records        = Records indexed by type id (NULL if not created)
+ * @mem tick           = Current change tick, stamped on added and changed components
+ */
+
+typedef struct {
+	u32 record_cnt;
+	u32 record_types[ISO_ECS_MAX_TYPES];
+	iso_comp_record* records[ISO_ECS_MAX_TYPES];
+	u32 tick;
+} iso_comp_table;
+
+
+/*
+ * @brief Function to create new iso_comp_table
+ * @return Returns pointer to iso_comp_table struct
+ */
+
+static iso_comp_table* iso_comp_table_new() {
+	iso_comp_table* table = iso_alloc(sizeof(iso_comp_table));
+	table->record_cnt = 0;
+	table->tick = 1;
+	return table;
+}
+
+
+/*
+ * @brief Function to delete iso_comp_table
+ * @param table = Pointer to the iso_comp_table
+ */
+
+static void iso_comp_table_delete(iso_comp_table* table) {
+	for (u32 i = 0; i < table->record_cnt; i++) {
+		iso_comp_record* rec = table->records[table->record_types[i]];
+		iso_comp_record_delete(rec);
+	}
+	iso_free(table);
+}
+
+
+/*
+ * @brief Function to search for component in iso_comp_table
+ * @param table = Pointer to the iso_comp_table
+ * @param type  = Type id of the component to be searched
+ * @return Returns True if found else False
+ */
+
+#define iso_comp_table_search(table, comp) __iso_comp_table_search(table, iso_ecs_type_id(comp))
+
+static b8 __iso_comp_table_search(iso_comp_table* table, u32 type) {
+	return type < ISO_ECS_MAX_TYPES && table->records[type] != NULL;
+}
+
+
+/*
+ * @brief Function to add new component record to the table
+ * @param table = Pointer to the iso_comp_table
+ * @param type  = Type id of the component to be added
+ */
+
+#define iso_comp_table_add_record(table, comp) __iso_comp_table_add_record(table, iso_ecs_type_id(comp))
+
+static void __iso_comp_table_add_record(iso_comp_table* table, u32 type) {
+	iso_assert(table->records[type] == NULL, "Record of component `%s` already exists.\n", iso_ecs_type_name(type));
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	table->records[type] = iso_comp_record_new(type, &table->tick);
+	table->record_types[table->record_cnt++] = type;
+	iso_memory_pop_tag();
+}
+
+
+/*
+ * @brief Function to get the component record from the table
+ * @param table = Pointer to the iso_comp_table
+ * @param type  = Type id of the component to get
+ * @return Returns pointer to iso_comp_record if found else NULL is returned
+ */
+
+#define iso_comp_table_get_record(table, comp) __iso_comp_table_get_record(table, iso_ecs_type_id(comp))
+
+static iso_comp_record* __iso_comp_table_get_record(iso_comp_table* table, u32 type) {
+	return table->records[type];
+}
+
+
+/* =======================
+ * Entity Component System
+ * ======================= */
+
+
+typedef struct iso_ecs iso_ecs;
+
+/*
+ * @brief Kind of a deferred ecs command
+ */
+
+typedef enum {
+	ISO_ECS_CMD_CREATE,
+	ISO_ECS_CMD_ADD,
+	ISO_ECS_CMD_REMOVE,
+	ISO_ECS_CMD_DESTROY
+} iso_ecs_cmd_kind;
+
+/*
+ * @brief Deferred ecs command
+ * @mem kind = Kind of the command
+ * @mem type = Type id of the component (ADD and REMOVE)
+ * @mem ent  = Target entity (can be a pending entity of the same buffer)
+ * @mem data = Offset of the component data in the data of the buffer (ADD)
+ */
+
+typedef struct {
+	iso_ecs_cmd_kind kind;
+	u32 type;
+	iso_entity ent;
+	u32 data;
+} iso_ecs_cmd;
+
+/*
+ * @brief Buffer of structural changes that are applied later at a sync point
+ * @mem cmds       = Recorded commands
+ * @mem cmd_cnt    = No of commands
+ * @mem cmd_cap    = Capacity of `cmds`
+ * @mem data       = Copied component data of the ADD commands
+ * @mem data_size  = Used bytes of `data`
+ * @mem data_cap   = Capacity of `data`
+ * @mem create_cnt = No of entities created in the buffer
+ * @mem created    = Entities made for the pending ones during playback
+ */
+
+typedef struct {
+	iso_ecs_cmd* cmds;
+	u32 cmd_cnt;
+	u32 cmd_cap;
+	u8* data;
+	u32 data_size;
+	u32 data_cap;
+	u32 create_cnt;
+	iso_entity* created;
+} iso_ecs_cmd_buffer;
+
+/*
+ * @brief Function run by a system
+ * @param ecs  = Pointer to the iso_ecs
+ * @param data = User data of the system
+ */
+
+typedef void (*iso_ecs_system_fn)(iso_ecs* ecs, void* data);
+
+/*
+ * @brief System of the ecs. Systems that dont write components used by each other
+ *        run at the same time (see iso_ecs_run_systems).
+ * @mem name      = Name of the system
+ * @mem fn        = Function of the system
+ * @mem data      = User data passed to the function
+ * @mem reads     = Components the system reads (iso_ecs_system_reads)
+ * @mem writes    = Components the system writes (iso_ecs_system_writes)
+ * @mem exclusive = Runs the system alone, e.g. when it adds or removes components
+ * @mem ecs       = Ecs the system is registered to
+ */
+
+typedef struct {
+	char* name;
+	iso_ecs_system_fn fn;
+	void* data;
+	iso_ecs_mask reads;
+	iso_ecs_mask writes;
+	b8 exclusive;
+	iso_ecs* ecs;
+} iso_ecs_system;
+
+
+/*
+ * @brief Structure that holds entire component in the system
+ * @mem entities       = Allocator of the entity handles
+ * @mem signatures     = Components of every entity slot as a mask
+ * @mem signature_cap  = No of entries in `signatures` (grows with the entity slots)
+ * @mem table          = Pointer to the iso_comp_table
+ * @mem pool           = Thread pool the systems and parallel queries run on (NULL runs them serially)
+ * @mem systems        = Registered systems in registration order
+ * @mem system_cnt     = No of systems
+ * @mem schedule       = System indices ordered by wave
+ * @mem wave_starts    = Start of every wave in `schedule` (wave_cnt + 1 entries)
+ * @mem wave_cnt       = No of waves
+ * @mem schedule_dirty = Set when a system is added and the schedule has to be rebuilt
+ * @mem jobs           = Jobs submitted for a wave
+ * @mem cmd_buffers    = Command buffer of every thread (indexed by iso_thread_pool_worker_index)
+ */
+
+struct iso_ecs {
+	iso_entity_allocator entities;
+	iso_ecs_mask* signatures;
+	u32 signature_cap;
+	iso_comp_table* table;
+	iso_thread_pool* pool;
+
+	iso_ecs_system* systems;
+	u32  system_cnt;
+	u32* schedule;
+	u32* wave_starts;
+	u32  wave_cnt;
+	b8   schedule_dirty;
+	iso_thread_job* jobs;
+
+	iso_ecs_cmd_buffer* cmd_buffers[ISO_THREAD_POOL_MAX_THREADS + 1];
+};
+
+static void iso_ecs_cmd_buffer_delete(iso_ecs_cmd_buffer* buf);
+
+
+/*
+ * @brief Function to create a new ecs. Entity slots and component storage grow on demand.
+ * @param entity_cap = No of entity slots allocated up front
+ * @return Returns pointer to iso_ecs struct
+ */
+
+static iso_ecs* iso_ecs_new(u32 entity_cap) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	iso_ecs* ecs = iso_alloc(sizeof(iso_ecs));
+
+	// Allocating entity slots
+	ecs->entities = iso_entity_allocator_new(entity_cap);
+	ecs->signatures = iso_alloc(sizeof(iso_ecs_mask) * ecs->entities.cap);
+	ecs->signature_cap = ecs->entities.cap;
+
+	// Creating table
+	ecs->table = iso_comp_table_new();
+
+	iso_memory_pop_tag();
+	return ecs;
+}
+
+
+/*
+ * @brief Function to delete iso_ecs
+ * @param ecs = Pointer to iso_ecs struct
+ */
+
+static void iso_ecs_delete(iso_ecs* ecs) {
+	//TODO: Fix this with proper log
+	if (ecs->entities.entity_cnt) {
+		printf("Not all the entities are deleted.\n");
+	}
+
+	iso_comp_table_delete(ecs->table);
+	iso_entity_allocator_delete(&ecs->entities);
+	iso_free(ecs->signatures);
+	iso_free(ecs->systems);
+	iso_free(ecs->schedule);
+	iso_free(ecs->wave_starts);
+	iso_free(ecs->jobs);
+	for (u32 i = 0; i <= ISO_THREAD_POOL_MAX_THREADS; i++) {
+		if (ecs->cmd_buffers[i]) iso_ecs_cmd_buffer_delete(ecs->cmd_buffers[i]);
+	}
+	iso_free(ecs);
+}
+
+
+/* =======================
+ * Entity Commands
+ * ======================= */
+
+
+/*
+ * @brief Internal function to grow the signatures along with the entity slots
+ * @param ecs = Pointer to iso_ecs
+ */
+
+static void __iso_ecs_sync_signatures(iso_ecs* ecs) {
+	u32 cap = ecs->entities.cap;
+	if (ecs->signature_cap >= cap) return;
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	ecs->signatures = iso_realloc(ecs->signatures, sizeof(iso_ecs_mask) * cap);
+	memset(ecs->signatures + ecs->signature_cap, 0, sizeof(iso_ecs_mask) * (cap - ecs->signature_cap));
+	ecs->signature_cap = cap;
+	iso_memory_pop_tag();
+}
+
+
+/*
+ * @brief Function to create new entity
+ * @param ecs = Pointer to iso_ecs
+ * @return Returns a iso_entity type which is a entity id
+ */
+
+static iso_entity iso_entity_new(iso_ecs* ecs) {
+	iso_entity ent = iso_entity_allocator_create(&ecs->entities);
+	__iso_ecs_sync_signatures(ecs);
+	return ent;
+}
+
+
+/*
+ * @brief Function to check if an entity handle is still alive
+ * @param ecs = Pointer to iso_ecs
+ * @param ent = iso_entity id
+ * @return Returns false for deleted entities, even if their slot got reused
+ */
+
+static b8 iso_entity_alive(iso_ecs* ecs, iso_entity ent) {
+	return iso_entity_allocator_alive(&ecs->entities, ent);
+}
+
+
+/*
+ * @brief Function to get the components of an entity as a mask
+ * @param ecs = Pointer to iso_ecs
+ * @param ent = iso_entity id
+ * @return Returns pointer to the signature of the entity
+ */
+
+static iso_ecs_mask* iso_entity_signature(iso_ecs* ecs, iso_entity ent) {
+	iso_assert(iso_entity_alive(ecs, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+	return &ecs->signatures[iso_entity_index(ent)];
+}
+
+
+/*
+ * @brief Function to delete an entity
+ * @param ecs = Pointer to the iso_ecs
+ * @param ent = iso_entity id
+ */
+
+static void iso_entity_delete(iso_ecs* ecs, iso_entity ent) {
+	iso_assert(iso_entity_alive(ecs, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	// Visiting only the records of the components the entity has
+	iso_ecs_mask* sig = &ecs->signatures[iso_entity_index(ent)];
+	for (u32 w = 0; w < ISO_ECS_MASK_WORDS; w++) {
+		for (u64 bits = sig->bits[w]; bits; bits &= bits - 1) {
+			iso_comp_record_remove_entry(ecs->table->records[w * 64 + __builtin_ctzll(bits)], ent);
+		}
+	}
+	*sig = (iso_ecs_mask) { 0 };
+
+	// Reseting the slot
+	iso_entity_allocator_destroy(&ecs->entities, ent);
+}
+
+
+/*
+ * @brief Function to create a batch of entities
+ * @param ecs = Pointer to iso_ecs
+ * @param out = Array that receives the `cnt` new entities
+ * @param cnt = No of entities to create
+ */
+
+static void iso_entity_new_bulk(iso_ecs* ecs, iso_entity* out, u32 cnt) {
+	iso_entity_allocator_create_bulk(&ecs->entities, out, cnt);
+	__iso_ecs_sync_signatures(ecs);
+}
+
+
+/*
+ * @brief Function to delete a batch of entities. Each record is visited once for the whole
+ *        batch instead of once per entity. Pass `ents + start` to delete a range of an array.
+ *        Handles repeated in the batch are deleted once.
+ * @param ecs  = Pointer to the iso_ecs
+ * @param ents = Array of entities to delete
+ * @param cnt  = No of entities
+ */
+
+static void iso_entity_delete_bulk(iso_ecs* ecs, iso_entity* ents, u32 cnt) {
+	// Collecting the components the batch has, so untouched records are skipped
+	iso_ecs_mask used = { 0 };
+	for (u32 i = 0; i < cnt; i++) {
+		iso_assert(iso_entity_alive(ecs, ents[i]), "Entity `%u` doesnt exists.\n", iso_entity_index(ents[i]));
+		iso_ecs_mask* sig = &ecs->signatures[iso_entity_index(ents[i])];
+		for (u32 w = 0; w < ISO_ECS_MASK_WORDS; w++) {
+			used.bits[w] |= sig->bits[w];
+		}
+	}
+
+	for (u32 w = 0; w < ISO_ECS_MASK_WORDS; w++) {
+		for (u64 bits = used.bits[w]; bits; bits &= bits - 1) {
+			iso_comp_record_remove_entries(ecs->table->records[w * 64 + __builtin_ctzll(bits)], ents, cnt);
+		}
+	}
+
+	for (u32 i = 0; i < cnt; i++) {
+		// A repeated handle finds its slot already freed
+		if (!iso_entity_alive(ecs, ents[i])) continue;
+		ecs->signatures[iso_entity_index(ents[i])] = (iso_ecs_mask) { 0 };
+		iso_entity_allocator_destroy(&ecs->entities, ents[i]);
+	}
+}
+
+
+/*
+ * @brief Internal function to get the record of a component, creating it if needed
+ * @param ecs  = Pointer to iso_ecs
+ * @param type = Type id of the component
+ * @return Returns pointer to the iso_comp_record
+ */
+
+static iso_comp_record* __iso_ecs_get_or_add_record(iso_ecs* ecs, u32 type) {
+	if (ecs->table->records[type] == NULL) {
+		__iso_comp_table_add_record(ecs->table, type);
+	}
+	return ecs->table->records[type];
+}
+
+
+/*
+ * @brief Internal function to set the alignment of a component's data
+ * @param ecs   = Pointer to iso_ecs
+ * @param type  = Type id of the component
+ * @param align = Alignment in bytes (power of two)
+ */
+
+static void __iso_ecs_set_component_align(iso_ecs* ecs, u32 type, u32 align) {
+	iso_comp_record* rec = __iso_ecs_get_or_add_record(ecs, type);
+	iso_comp_record_set_align(rec, align);
+}
+
+
+/*
+ * @brief Internal function to add the slot of a component to an entity, without initializing it
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @param size = Size of the component
+ * @return Returns pointer to the slot of the component inside the record
+ */
+
+static void* __iso_entity_push_component(iso_ecs* ecs, iso_entity ent, u32 type, size_t size) {
+	iso_assert(iso_entity_alive(ecs, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_comp_record* rec = __iso_ecs_get_or_add_record(ecs, type);
+	iso_assert(rec->align ? rec->size >= size : rec->size == size, "Component `%s` added with a different size.\n", rec->name);
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	u8* comp = __iso_comp_record_push(rec, ent);
+	iso_memory_pop_tag();
+
+	// Zeroing the padding of aligned components
+	if (rec->size > size) memset(comp + size, 0, rec->size - size);
+
+	iso_ecs_mask_set(&ecs->signatures[iso_entity_index(ent)], type);
+
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to add component to entity
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @param data = Data of the component, copied into the component storage
+ * @param size = Size of the component data
+ * @return Returns pointer to the component inside the record
+ */
+
+static void* __iso_entity_add_component(iso_ecs* ecs, iso_entity ent, u32 type, void* data, size_t size) {
+	void* comp = __iso_entity_push_component(ecs, ent, type, size);
+	if (size) memcpy(comp, data, size);
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to construct a component of an entity in place
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @param size = Size of the component
+ * @return Returns pointer to the component inside the record
+ */
+
+static void* __iso_entity_emplace_component(iso_ecs* ecs, iso_entity ent, u32 type, size_t size) {
+	void* comp = __iso_entity_push_component(ecs, ent, type, size);
+	if (size == 0) return comp;
+	memset(comp, 0, size);
+
+	iso_ecs_type_hooks* hooks = ecs->table->records[type]->hooks;
+	if (hooks->ctor) hooks->ctor(comp, 1, ecs->table->records[type]->size);
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to get the component from entity
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @return Returns pointer to the component data
+ */
+
+static void* __iso_entity_get_component(iso_ecs* ecs, iso_entity ent, u32 type) {
+	iso_assert(iso_entity_alive(ecs, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_comp_record* rec = ecs->table->records[type];
+	iso_assert(rec, "Component `%s` is not in component table.\n", iso_ecs_type_name(type));
+	iso_assert(!rec->tag, "Component `%s` is a tag and has no data.\n", rec->name);
+
+	void* comp = iso_comp_record_get_entry(rec, ent);
+	iso_assert(comp, "Entity `%u` doesnt have component `%s`\n", iso_entity_index(ent), rec->name);
+
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to get the component from entity and stamp it as changed
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @return Returns pointer to the component data
+ */
+
+static void* __iso_entity_get_component_mut(iso_ecs* ecs, iso_entity ent, u32 type) {
+	void* comp = __iso_entity_get_component(ecs, ent, type);
+	iso_comp_record* rec = ecs->table->records[type];
+	iso_comp_record_mark_changed(rec, iso_comp_record_sparse_get(rec, iso_entity_index(ent)));
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to remove component from entity
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ */
+
+static void __iso_entity_remove_component(iso_ecs* ecs, iso_entity ent, u32 type) {
+	iso_assert(iso_entity_alive(ecs, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_ecs_mask* sig = &ecs->signatures[iso_entity_index(ent)];
+	iso_assert(iso_ecs_mask_has(sig, type), "Entity `%u` doesnt have component `%s`.\n", iso_entity_index(ent), iso_ecs_type_name(type));
+
+	iso_comp_record_remove_entry(ecs->table->records[type], ent);
+	iso_ecs_mask_clear(sig, type);
+}
+
+
+/*
+ * @brief Internal function to add a component to a batch of entities
+ * @param ecs  = Pointer to iso_ecs
+ * @param ents = Array of entities
+ * @param cnt  = No of entities
+ * @param type = Type id of the component
+ * @param data = Array of `cnt` components copied into the component storage (NULL to construct them in place)
+ * @param size = Size of a component of `data`
+ * @return Returns pointer to the component of the first entity inside the record
+ */
+
+static void* __iso_entity_add_component_bulk(iso_ecs* ecs, iso_entity* ents, u32 cnt, u32 type, void* data, size_t size) {
+	for (u32 i = 0; i < cnt; i++) {
+		iso_assert(iso_entity_alive(ecs, ents[i]), "Entity `%u` doesnt exists.\n", iso_entity_index(ents[i]));
+	}
+
+	iso_comp_record* rec = __iso_ecs_get_or_add_record(ecs, type);
+	iso_assert(rec->align ? rec->size >= size : rec->size == size, "Component `%s` added with a different size.\n", rec->name);
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	void* comps = iso_comp_record_add_entries(rec, ents, cnt, data, size);
+	iso_memory_pop_tag();
+
+	for (u32 i = 0; i < cnt; i++) {
+		iso_ecs_mask_set(&ecs->signatures[iso_entity_index(ents[i])], type);
+	}
+
+	return comps;
+}
+
+
+/*
+ * @brief Macro to add a new component. The parameters are copied into the slot of the
+ *        component (the constructor of the type is not run, the destructor will be).
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ * @param ...  = Component parameters
+ */
+
+#define iso_entity_add_component(ecs, ent, comp, ...)                                \
+	({                                                                                 \
+		comp c = { __VA_ARGS__ };                                                        \
+		(comp*) __iso_entity_add_component(ecs, ent, iso_ecs_type_id(comp), &c, sizeof(c)); \
+	})                                                                                 \
+
+
+/*
+ * @brief Macro to add a new component constructed in place by the constructor of its
+ *        type (zeroed if it has none), e.g. to fill it in through the returned pointer
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_entity_emplace_component(ecs, ent, comp)\
+	((comp*) __iso_entity_emplace_component(ecs, ent, iso_ecs_type_id(comp), sizeof(comp)))
+
+
+/*
+ * @brief Macro to add a component to a batch of entities. The components of the
+ *        batch end up next to each other in the record, in the order of `ents`.
+ * @param ecs  = Pointer to iso_ecs
+ * @param ents = Array of entities
+ * @param cnt  = No of entities
+ * @param comp = Component structure
+ * @param data = Array of `cnt` components (NULL to construct them in place)
+ */
+
+#define iso_entity_add_component_bulk(ecs, ents, cnt, comp, data)\
+	((comp*) __iso_entity_add_component_bulk(ecs, ents, cnt, iso_ecs_type_id(comp), data, sizeof(comp)))
+
+
+/*
+ * @brief Macro to align the data of a component, e.g. to ISO_CACHE_LINE_SIZE so that
+ *        components written by different threads never share a cache line.
+ *        Must be called before the component is added to any entity.
+ * @param ecs   = Pointer to iso_ecs
+ * @param comp  = Component structure
+ * @param align = Alignment in bytes (power of two)
+ */
+
+#define iso_ecs_set_component_align(ecs, comp, align)\
+	__iso_ecs_set_component_align(ecs, iso_ecs_type_id(comp), align)
+
+
+/*
+ * @brief Macro to get a component
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_entity_get_component(ecs, ent, comp)\
+	__iso_entity_get_component(ecs, ent, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to get a component that is going to be written. The component is
+ *        stamped as changed, so queries filtering on iso_ecs_query_changed see it.
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_entity_get_component_mut(ecs, ent, comp)\
+	__iso_entity_get_component_mut(ecs, ent, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to remove a component
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_entity_remove_component(ecs, ent, comp)\
+	__iso_entity_remove_component(ecs, ent, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to check if an entity has a component (a bit test on its signature)
+ * @param ecs  = Pointer to iso_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_entity_has_component(ecs, ent, comp)\
+	iso_ecs_mask_has(iso_entity_signature(ecs, ent), iso_ecs_type_id(comp))
+
+/*
+ * @brief Macro to get the record of a component to iterate it linearly:
+ *          iso_comp_record* rec = iso_ecs_get_record(ecs, comp);
+ *          comp* data = (comp*) rec->data;
+ *          for (u32 i = 0; i < rec->entry_cnt; i++) { rec->entities[i], data[i] ... }
+ *        Components given a bigger alignment are `rec->size` bytes apart instead.
+ *        Returns NULL if no entity ever had the component.
+ * @param ecs  = Pointer to iso_ecs
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_get_record(ecs, comp)\
+	__iso_comp_table_get_record((ecs)->table, iso_ecs_type_id(comp))
+
+
+/* =======================
+ * Command Buffers
+ * ======================= */
+
+
+/*
+ * @brief Function to create a command buffer
+ * @return Returns pointer to iso_ecs_cmd_buffer
+ */
+
+static iso_ecs_cmd_buffer* iso_ecs_cmd_buffer_new() {
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	iso_ecs_cmd_buffer* buf = iso_alloc(sizeof(iso_ecs_cmd_buffer));
+	iso_memory_pop_tag();
+	return buf;
+}
+
+
+/*
+ * @brief Function to delete a command buffer
+ * @param buf = Pointer to iso_ecs_cmd_buffer
+ */
+
+static void iso_ecs_cmd_buffer_delete(iso_ecs_cmd_buffer* buf) {
+	iso_free(buf->cmds);
+	iso_free(buf->data);
+	iso_free(buf->created);
+	iso_free(buf);
+}
+
+
+/*
+ * @brief Internal function to append a command to the buffer
+ * @param buf  = Pointer to iso_ecs_cmd_buffer
+ * @param cmd  = Command to append
+ */
+
+static void __iso_ecs_cmd_push(iso_ecs_cmd_buffer* buf, iso_ecs_cmd cmd) {
+	if (buf->cmd_cnt == buf->cmd_cap) {
+		buf->cmd_cap = buf->cmd_cap ? buf->cmd_cap * 2 : 64;
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		buf->cmds = iso_realloc(buf->cmds, sizeof(iso_ecs_cmd) * buf->cmd_cap);
+		iso_memory_pop_tag();
+	}
+	buf->cmds[buf->cmd_cnt++] = cmd;
+}
+
+
+/*
+ * @brief Function to record the creation of an entity. The returned handle is pending,
+ *        it can only be used with commands of the same buffer until the playback.
+ * @param buf = Pointer to iso_ecs_cmd_buffer
+ * @return Returns the pending iso_entity
+ */
+
+static iso_entity iso_ecs_cmd_create(iso_ecs_cmd_buffer* buf) {
+	// Pending entities have version 0, which live entities never have
+	iso_entity ent = iso_entity_make(++buf->create_cnt, 0);
+	__iso_ecs_cmd_push(buf, (iso_ecs_cmd) { ISO_ECS_CMD_CREATE, 0, ent, 0 });
+	return ent;
+}
+
+
+/*
+ * @brief Function to record the deletion of an entity
+ * @param buf = Pointer to iso_ecs_cmd_buffer
+ * @param ent = iso_entity (live or pending)
+ */
+
+static void iso_ecs_cmd_destroy(iso_ecs_cmd_buffer* buf, iso_entity ent) {
+	__iso_ecs_cmd_push(buf, (iso_ecs_cmd) { ISO_ECS_CMD_DESTROY, 0, ent, 0 });
+}
+
+
+/*
+ * @brief Internal function to record adding a component to an entity
+ * @param buf  = Pointer to iso_ecs_cmd_buffer
+ * @param ent  = iso_entity (live or pending)
+ * @param type = Type id of the component
+ * @param data = Data of the component, copied into the buffer
+ * @param size = Size of the component
+ */
+
+static void __iso_ecs_cmd_add_component(iso_ecs_cmd_buffer* buf, iso_entity ent, u32 type, void* data, u32 size) {
+	if (buf->data_size + size > buf->data_cap) {
+		buf->data_cap = buf->data_cap ? buf->data_cap * 2 : 1024;
+		if (buf->data_cap < buf->data_size + size) buf->data_cap = buf->data_size + size;
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		buf->data = iso_realloc(buf->data, buf->data_cap);
+		iso_memory_pop_tag();
+	}
+
+	if (size) memcpy(buf->data + buf->data_size, data, size);
+	__iso_ecs_cmd_push(buf, (iso_ecs_cmd) { ISO_ECS_CMD_ADD, type, ent, buf->data_size });
+	buf->data_size += size;
+}
+
+
+/*
+ * @brief Internal function to record removing a component from an entity
+ * @param buf  = Pointer to iso_ecs_cmd_buffer
+ * @param ent  = iso_entity (live or pending)
+ * @param type = Type id of the component
+ */
+
+static void __iso_ecs_cmd_remove_component(iso_ecs_cmd_buffer* buf, iso_entity ent, u32 type) {
+	__iso_ecs_cmd_push(buf, (iso_ecs_cmd) { ISO_ECS_CMD_REMOVE, type, ent, 0 });
+}
+
+
+/*
+ * @brief Function to drop every command of the buffer
+ * @param buf = Pointer to iso_ecs_cmd_buffer
+ */
+
+static void iso_ecs_cmd_buffer_clear(iso_ecs_cmd_buffer* buf) {
+	buf->cmd_cnt    = 0;
+	buf->data_size  = 0;
+	buf->create_cnt = 0;
+}
+
+
+/*
+ * @brief Sort key of a command during playback
+ * @mem key = Destroys last, then type id, then buffer and position of the command
+ * @mem cmd = Pointer to the command
+ */
+
+typedef struct {
+	u64 key;
+	iso_ecs_cmd* cmd;
+} __iso_ecs_cmd_sort;
+
+static i32 __iso_ecs_cmd_compare(const void* a, const void* b) {
+	u64 ka = ((__iso_ecs_cmd_sort*) a)->key;
+	u64 kb = ((__iso_ecs_cmd_sort*) b)->key;
+	return ka < kb ? -1 : ka > kb;
+}
+
+
+/*
+ * @brief Function to apply the commands of several buffers at once and clear them.
+ *        Entities are created first, then the component commands are applied grouped
+ *        by component record (in recording order per record) and entities are deleted last.
+ *        Adding a component the entity already has overwrites it. Commands on entities
+ *        that are already deleted and removals of missing components are skipped.
+ * @param ecs     = Pointer to iso_ecs
+ * @param bufs    = Array of command buffers
+ * @param buf_cnt = No of buffers
+ */
+
+static void iso_ecs_cmd_buffer_playback(iso_ecs* ecs, iso_ecs_cmd_buffer** bufs, u32 buf_cnt) {
+	u32 total = 0;
+	for (u32 b = 0; b < buf_cnt; b++) {
+		total += bufs[b]->cmd_cnt;
+	}
+	if (total == 0) return;
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	__iso_ecs_cmd_sort* sorted = iso_alloc_uninit(sizeof(__iso_ecs_cmd_sort) * total);
+
+	// Creating the pending entities and resolving their handles
+	u32 cnt = 0;
+	for (u32 b = 0; b < buf_cnt; b++) {
+		iso_ecs_cmd_buffer* buf = bufs[b];
+		buf->created = iso_realloc(buf->created, sizeof(iso_entity) * (buf->create_cnt + 1));
+
+		u32 created = 0;
+		for (u32 i = 0; i < buf->cmd_cnt; i++) {
+			iso_ecs_cmd* cmd = &buf->cmds[i];
+			if (cmd->kind == ISO_ECS_CMD_CREATE) {
+				buf->created[created++] = iso_entity_new(ecs);
+				continue;
+			}
+			// ISO_ENTITY_NULL (index 0) is left as is, it is never alive so the command is skipped
+			u32 pending = iso_entity_index(cmd->ent);
+			if (iso_entity_version(cmd->ent) == 0 && pending != 0) {
+				iso_assert(pending <= created, "Pending entity `%u` was not created by this command buffer.\n", pending);
+				cmd->ent = buf->created[pending - 1];
+			}
+
+			u64 last = cmd->kind == ISO_ECS_CMD_DESTROY;
+			sorted[cnt++] = (__iso_ecs_cmd_sort) { (last << 63) | ((u64) cmd->type << 48) | ((u64) b << 32) | i, cmd };
+		}
+	}
+	iso_memory_pop_tag();
+
+	qsort(sorted, cnt, sizeof(__iso_ecs_cmd_sort), __iso_ecs_cmd_compare);
+
+	u32 i = 0;
+	while (i < cnt && sorted[i].cmd->kind != ISO_ECS_CMD_DESTROY) {
+		u32 type = sorted[i].cmd->type;
+
+		// Finding the commands of the record and growing it once for all of its adds
+		u32 end = i, add_cnt = 0;
+		while (end < cnt && sorted[end].cmd->kind != ISO_ECS_CMD_DESTROY && sorted[end].cmd->type == type) {
+			add_cnt += sorted[end].cmd->kind == ISO_ECS_CMD_ADD;
+			end++;
+		}
+
+		iso_comp_record* rec = __iso_ecs_get_or_add_record(ecs, type);
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		iso_comp_record_reserve(rec, rec->entry_cnt + add_cnt);
+		iso_memory_pop_tag();
+
+		for (; i < end; i++) {
+			iso_ecs_cmd* cmd = sorted[i].cmd;
+			if (!iso_entity_alive(ecs, cmd->ent)) continue;
+
+			iso_ecs_cmd_buffer* buf = bufs[(sorted[i].key >> 32) & 0xFFFF];
+			b8 has = iso_comp_record_search(rec, cmd->ent);
+
+			iso_ecs_mask* sig = &ecs->signatures[iso_entity_index(cmd->ent)];
+			if (cmd->kind == ISO_ECS_CMD_ADD) {
+				if (has && !rec->tag) {
+					void* comp = iso_comp_record_get_entry(rec, cmd->ent);
+					if (rec->hooks->dtor) rec->hooks->dtor(comp, 1, rec->size);
+					memcpy(comp, buf->data + cmd->data, iso_ecs_type_size(type));
+					iso_comp_record_mark_changed(rec, iso_comp_record_sparse_get(rec, iso_entity_index(cmd->ent)));
+				} else if (!has) {
+					// The buffer only holds the size of the type, aligned records have a bigger stride
+					u8* slot = __iso_comp_record_push(rec, cmd->ent);
+					if (!rec->tag) {
+						u32 size = iso_ecs_type_size(type);
+						memcpy(slot, buf->data + cmd->data, size);
+						if (rec->size > size) memset(slot + size, 0, rec->size - size);
+					}
+				}
+				iso_ecs_mask_set(sig, type);
+			} else if (has) {
+				iso_comp_record_remove_entry(rec, cmd->ent);
+				iso_ecs_mask_clear(sig, type);
+			}
+		}
+	}
+
+	for (; i < cnt; i++) {
+		iso_entity ent = sorted[i].cmd->ent;
+		if (iso_entity_alive(ecs, ent)) iso_entity_delete(ecs, ent);
+	}
+
+	iso_free(sorted);
+	for (u32 b = 0; b < buf_cnt; b++) {
+		iso_ecs_cmd_buffer_clear(bufs[b]);
+	}
+}
+
+
+/*
+ * @brief Function to get the command buffer of the calling thread.
+ *        Systems running in parallel record into their own buffer.
+ * @param ecs = Pointer to iso_ecs
+ * @return Returns pointer to the iso_ecs_cmd_buffer of the thread
+ */
+
+static iso_ecs_cmd_buffer* iso_ecs_get_cmd_buffer(iso_ecs* ecs) {
+	u32 idx = iso_thread_pool_worker_index();
+	iso_assert(idx <= ISO_THREAD_POOL_MAX_THREADS, "Worker index `%u` is out of range.\n", idx);
+	if (ecs->cmd_buffers[idx] == NULL) ecs->cmd_buffers[idx] = iso_ecs_cmd_buffer_new();
+	return ecs->cmd_buffers[idx];
+}
+
+
+/*
+ * @brief Function to play back the command buffers of every thread.
+ *        Called by iso_ecs_run_systems after every wave.
+ * @param ecs = Pointer to iso_ecs
+ */
+
+static void iso_ecs_flush_cmd_buffers(iso_ecs* ecs) {
+	iso_ecs_cmd_buffer* bufs[ISO_THREAD_POOL_MAX_THREADS + 1];
+	u32 cnt = 0;
+	for (u32 i = 0; i <= ISO_THREAD_POOL_MAX_THREADS; i++) {
+		if (ecs->cmd_buffers[i] && ecs->cmd_buffers[i]->cmd_cnt) bufs[cnt++] = ecs->cmd_buffers[i];
+	}
+	iso_ecs_cmd_buffer_playback(ecs, bufs, cnt);
+}
+
+
+/*
+ * @brief Macro to record adding a component
+ * @param buf  = Pointer to iso_ecs_cmd_buffer
+ * @param ent  = iso_entity (live or pending)
+ * @param comp = Component structure
+ * @param ...  = Component parameters
+ */
+
+#define iso_ecs_cmd_add_component(buf, ent, comp, ...)                          \
+	({                                                                            \
+		comp c = { __VA_ARGS__ };                                                   \
+		__iso_ecs_cmd_add_component(buf, ent, iso_ecs_type_id(comp), &c, sizeof(c)); \
+	})                                                                            \
+
+
+/*
+ * @brief Macro to record removing a component
+ * @param buf  = Pointer to iso_ecs_cmd_buffer
+ * @param ent  = iso_entity (live or pending)
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_cmd_remove_component(buf, ent, comp)\
+	__iso_ecs_cmd_remove_component(buf, ent, iso_ecs_type_id(comp))
+
+
+/* =======================
+ * Systems
+ * ======================= */
+
+
+/*
+ * @brief Function to set the thread pool used by the systems and parallel queries
+ * @param ecs  = Pointer to iso_ecs
+ * @param pool = Pointer to iso_thread_pool (NULL to run everything on the calling thread)
+ */
+
+static void iso_ecs_set_thread_pool(iso_ecs* ecs, iso_thread_pool* pool) {
+	ecs->pool = pool;
+}
+
+
+/*
+ * @brief Function to register a system. Systems are run by iso_ecs_run_systems,
+ *        conflicting systems always run in registration order:
+ *          iso_ecs_system sys = { .name = "movement", .fn = movement };
+ *          iso_ecs_system_reads(&sys, vel);
+ *          iso_ecs_system_writes(&sys, pos);
+ *          iso_ecs_add_system(ecs, sys);
+ * @param ecs    = Pointer to iso_ecs
+ * @param system = Definition of the system
+ */
+
+static void iso_ecs_add_system(iso_ecs* ecs, iso_ecs_system system) {
+	iso_assert(system.fn, "System `%s` has no function.\n", system.name);
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	ecs->systems = iso_realloc(ecs->systems, sizeof(iso_ecs_system) * (ecs->system_cnt + 1));
+	iso_memory_pop_tag();
+
+	system.ecs = ecs;
+	ecs->systems[ecs->system_cnt++] = system;
+	ecs->schedule_dirty = true;
+}
+
+
+/*
+ * @brief Internal function to check if two systems can not run at the same time
+ * @param a = Pointer to iso_ecs_system
+ * @param b = Pointer to iso_ecs_system
+ * @return Returns true if one of the systems writes a component the other one uses
+ */
+
+static b8 __iso_ecs_systems_conflict(iso_ecs_system* a, iso_ecs_system* b) {
+	if (a->exclusive || b->exclusive) return true;
+	return iso_ecs_mask_intersects(&a->writes, &b->writes)
+	    || iso_ecs_mask_intersects(&a->writes, &b->reads)
+	    || iso_ecs_mask_intersects(&a->reads,  &b->writes);
+}
+
+
+/*
+ * @brief Internal function to build the dependency graph of the systems and split it in waves.
+ *        A system depends on every earlier conflicting system and is placed one wave
+ *        after the last of them, so the systems of a wave never conflict.
+ * @param ecs = Pointer to iso_ecs
+ */
+
+static void __iso_ecs_build_schedule(iso_ecs* ecs) {
+	u32 cnt = ecs->system_cnt;
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	ecs->schedule    = iso_realloc(ecs->schedule, sizeof(u32) * cnt);
+	ecs->wave_starts = iso_realloc(ecs->wave_starts, sizeof(u32) * (cnt + 1));
+	ecs->jobs        = iso_realloc(ecs->jobs, sizeof(iso_thread_job) * cnt);
+	u32* waves = iso_alloc(sizeof(u32) * cnt);
+	iso_memory_pop_tag();
+
+	ecs->wave_cnt = 0;
+	for (u32 j = 0; j < cnt; j++) {
+		waves[j] = 0;
+		for (u32 i = 0; i < j; i++) {
+			if (waves[i] + 1 > waves[j] && __iso_ecs_systems_conflict(&ecs->systems[i], &ecs->systems[j])) {
+				waves[j] = waves[i] + 1;
+			}
+		}
+		if (waves[j] + 1 > ecs->wave_cnt) ecs->wave_cnt = waves[j] + 1;
+	}
+
+	// Ordering the systems by wave, keeping the registration order inside a wave
+	u32 pos = 0;
+	for (u32 w = 0; w < ecs->wave_cnt; w++) {
+		ecs->wave_starts[w] = pos;
+		for (u32 j = 0; j < cnt; j++) {
+			if (waves[j] == w) ecs->schedule[pos++] = j;
+		}
+	}
+	ecs->wave_starts[ecs->wave_cnt] = pos;
+
+	iso_free(waves);
+	ecs->schedule_dirty = false;
+}
+
+
+/*
+ * @brief Internal job that runs a single system
+ */
+
+static void __iso_ecs_system_job(void* data, u32 start, u32 end) {
+	(void) start;
+	(void) end;
+	iso_ecs_system* system = data;
+	system->fn(system->ecs, system->data);
+}
+
+
+/*
+ * @brief Function to run every registered system once. Waves of non-conflicting
+ *        systems run concurrently on the thread pool of the ecs, the call returns
+ *        after all of them finished. Systems must record structural changes in
+ *        iso_ecs_get_cmd_buffer, the buffers are played back after every wave.
+ * @param ecs = Pointer to iso_ecs
+ */
+
+static void iso_ecs_run_systems(iso_ecs* ecs) {
+	if (ecs->schedule_dirty) __iso_ecs_build_schedule(ecs);
+
+	for (u32 w = 0; w < ecs->wave_cnt; w++) {
+		u32 start = ecs->wave_starts[w];
+		u32 cnt   = ecs->wave_starts[w + 1] - start;
+
+		// Lone systems run on the calling thread so that they can use the pool themselves
+		if (cnt == 1) {
+			iso_ecs_system* system = &ecs->systems[ecs->schedule[start]];
+			system->fn(ecs, system->data);
+		} else {
+			for (u32 i = 0; i < cnt; i++) {
+				ecs->jobs[i] = (iso_thread_job) { __iso_ecs_system_job, &ecs->systems[ecs->schedule[start + i]], 0, 0 };
+			}
+			iso_thread_pool_run(ecs->pool, ecs->jobs, cnt);
+		}
+
+		// Sync point, applying the structural changes recorded by the wave
+		iso_ecs_flush_cmd_buffers(ecs);
+	}
+}
+
+
+/*
+ * @brief Macro to declare a component that the system reads
+ * @param system = Pointer to iso_ecs_system
+ * @param comp   = Component structure
+ */
+
+#define iso_ecs_system_reads(system, comp)\
+	iso_ecs_mask_set(&(system)->reads, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to declare a component that the system writes
+ * @param system = Pointer to iso_ecs_system
+ * @param comp   = Component structure
+ */
+
+#define iso_ecs_system_writes(system, comp)\
+	iso_ecs_mask_set(&(system)->writes, iso_ecs_type_id(comp))
 
 #endif // __ISO_ECS_H__
@@ -0,0 +1,714 @@
+#ifndef __ISO_ECS_ARCHETYPE_H__
+#define __ISO_ECS_ARCHETYPE_H__
+
+#include "iso_util/iso_includes.h"
+#include "iso_util/iso_defines.h"
+#include "iso_util/iso_memory.h"
+#include "iso_util/iso_pool.h"
+#include "iso_ecs.h"
+
+/*
+ * Archetype storage
+ *
+ * Alternative to the iso_comp_table layout for entities that share the same
+ * component sets. Every distinct set of components (the signature) gets an
+ * iso_archetype and its entities live in fixed size chunks. A chunk stores
+ * each component as its own column (SoA):
+ *
+ * chunk = { cnt | entities[cap] | comp_1[cap] | comp_2[cap] ... }
+ *
+ * Adding or removing a component moves the entity to the archetype of the
+ * new signature. Queries walk the columns of every matching chunk without
+ * any per-entity lookups.
+ *
+ * Lifetime hooks (iso_ecs_set_type_hooks) are partly supported: an added
+ * component takes the given value as is, like iso_entity_add_component, so
+ * the ctor never runs. The dtor runs when the component is removed, its
+ * entity deleted or the ecs deleted. Moves between archetypes are plain
+ * copies, the move hook is not used.
+ */
+
+// Size of a single chunk of an archetype
+#define ISO_ARCH_CHUNK_SIZE (16 * 1024)
+
+// Alignment of every column inside a chunk
+#define ISO_ARCH_COLUMN_ALIGN 16
+
+#define __iso_arch_align(x) (((x) + ISO_ARCH_COLUMN_ALIGN - 1) & ~(ISO_ARCH_COLUMN_ALIGN - 1))
+
+
+/* =======================
+ * Archetype
+ * ======================= */
+
+
+/*
+ * @brief Header of an archetype chunk. The columns follow it in the same chunk.
+ * @mem cnt = No of entities stored in the chunk
+ */
+
+typedef struct {
+	u32 cnt;
+} iso_arch_chunk;
+
+#define ISO_ARCH_CHUNK_HEADER_SIZE __iso_arch_align(sizeof(iso_arch_chunk))
+
+
+/*
+ * @brief Storage of all the entities that have exactly the same component types
+ * @mem mask         = Signature of the archetype
+ * @mem comp_cnt     = No of component types
+ * @mem type_ids     = Component types of the archetype (ascending)
+ * @mem sizes        = Size of each component type
+ * @mem offsets      = Offset of each column from the start of a chunk
+ * @mem columns      = Component type to index in `type_ids` (-1 if absent)
+ * @mem ent_offset   = Offset of the entity column from the start of a chunk
+ * @mem chunk_cap    = No of entities a chunk can hold
+ * @mem chunks       = Chunks of the archetype, only the last one can be partially filled
+ * @mem chunk_cnt    = No of chunks
+ * @mem chunk_max    = Capacity of `chunks`
+ * @mem entity_cnt   = No of entities in the archetype
+ * @mem add_edges    = Cache of the archetype reached by adding a component type
+ * @mem remove_edges = Cache of the archetype reached by removing a component type
+ */
+
+typedef struct iso_archetype iso_archetype;
+struct iso_archetype {
+	iso_ecs_mask mask;
+	u32  comp_cnt;
+	u32* type_ids;
+	u32* sizes;
+	u32* offsets;
+	i32  columns[ISO_ECS_MAX_TYPES];
+	u32  ent_offset;
+	u32  chunk_cap;
+
+	iso_arch_chunk** chunks;
+	u32 chunk_cnt;
+	u32 chunk_max;
+	u32 entity_cnt;
+
+	iso_archetype* add_edges[ISO_ECS_MAX_TYPES];
+	iso_archetype* remove_edges[ISO_ECS_MAX_TYPES];
+};
+
+
+/*
+ * @brief Function to get a column of a chunk
+ * @param arch  = Pointer to iso_archetype
+ * @param chunk = Chunk of the archetype
+ * @param col   = Index of the component in the archetype
+ * @return Returns pointer to the first component of the column
+ */
+
+static u8* iso_arch_chunk_column(iso_archetype* arch, iso_arch_chunk* chunk, u32 col) {
+	return (u8*) chunk + arch->offsets[col];
+}
+
+static iso_entity* iso_arch_chunk_entities(iso_archetype* arch, iso_arch_chunk* chunk) {
+	return (iso_entity*) ((u8*) chunk + arch->ent_offset);
+}
+
+
+/*
+ * @brief Function to create an archetype and lay out its chunk columns
+ * @param mask = Signature of the archetype
+ * @return Returns pointer to the iso_archetype
+ */
+
+static iso_archetype* iso_archetype_new(iso_ecs_mask mask) {
+	iso_archetype* arch = iso_alloc(sizeof(iso_archetype));
+	arch->mask = mask;
+
+	for (u32 i = 0; i < ISO_ECS_MAX_TYPES; i++) {
+		arch->columns[i] = -1;
+		if (iso_ecs_mask_has(&mask, i)) arch->comp_cnt++;
+	}
+
+	arch->type_ids = iso_alloc(sizeof(u32) * (arch->comp_cnt + 1));
+	arch->sizes    = iso_alloc(sizeof(u32) * (arch->comp_cnt + 1));
+	arch->offsets  = iso_alloc(sizeof(u32) * (arch->comp_cnt + 1));
+
+	u32 row_size = sizeof(iso_entity);
+	for (u32 i = 0, c = 0; i < ISO_ECS_MAX_TYPES; i++) {
+		if (!iso_ecs_mask_has(&mask, i)) continue;
+		arch->columns[i]  = c;
+		arch->type_ids[c] = i;
+		arch->sizes[c]    = iso_ecs_type_size(i);
+		row_size += arch->sizes[c];
+		c++;
+	}
+
+	// Leaving room for the padding of every column
+	u32 space = ISO_ARCH_CHUNK_SIZE - ISO_ARCH_CHUNK_HEADER_SIZE - (arch->comp_cnt + 1) * ISO_ARCH_COLUMN_ALIGN;
+	arch->chunk_cap = space / row_size;
+	iso_assert(arch->chunk_cap > 0, "Components of the archetype dont fit in a chunk of %d bytes.\n", ISO_ARCH_CHUNK_SIZE);
+
+	u32 offset = ISO_ARCH_CHUNK_HEADER_SIZE;
+	arch->ent_offset = offset;
+	offset = __iso_arch_align(offset + sizeof(iso_entity) * arch->chunk_cap);
+	for (u32 c = 0; c < arch->comp_cnt; c++) {
+		arch->offsets[c] = offset;
+		offset = __iso_arch_align(offset + arch->sizes[c] * arch->chunk_cap);
+	}
+
+	return arch;
+}
+
+
+/*
+ * @brief Internal function to run the dtor hooks of the components of consecutive rows of a chunk
+ * @param arch  = Pointer to iso_archetype
+ * @param chunk = Chunk of the archetype
+ * @param row   = First row
+ * @param cnt   = No of rows
+ */
+
+static void __iso_arch_destroy_rows(iso_archetype* arch, iso_arch_chunk* chunk, u32 row, u32 cnt) {
+	for (u32 c = 0; c < arch->comp_cnt; c++) {
+		iso_ecs_type_hooks* hooks = iso_ecs_get_type_hooks(arch->type_ids[c]);
+		if (hooks->dtor) hooks->dtor(iso_arch_chunk_column(arch, chunk, c) + row * arch->sizes[c], cnt, arch->sizes[c]);
+	}
+}
+
+
+/*
+ * @brief Function to delete the archetype, destroying its components, and give its chunks back to the pool
+ * @param arch       = Pointer to iso_archetype
+ * @param chunk_pool = Pool the chunks were allocated from
+ */
+
+static void iso_archetype_delete(iso_archetype* arch, iso_pool* chunk_pool) {
+	for (u32 i = 0; i < arch->chunk_cnt; i++) {
+		__iso_arch_destroy_rows(arch, arch->chunks[i], 0, arch->chunks[i]->cnt);
+		iso_pool_free(chunk_pool, arch->chunks[i]);
+	}
+	iso_free(arch->chunks);
+	iso_free(arch->type_ids);
+	iso_free(arch->sizes);
+	iso_free(arch->offsets);
+	iso_free(arch);
+}
+
+
+/* =======================
+ * Archetype ECS
+ * ======================= */
+
+
+/*
+ * @brief Location of an entity inside the archetypes
+ * @mem arch  = Archetype of the entity (NULL if the id is free)
+ * @mem chunk = Index of the chunk in the archetype
+ * @mem row   = Row in the chunk
+ */
+
+typedef struct {
+	iso_archetype* arch;
+	u32 chunk;
+	u32 row;
+} iso_arch_location;
+
+/*
+ * @brief Entity component system that stores entities in archetype chunks
+ * @mem entities       = Allocator of the entity handles
+ * @mem locations      = Location of every entity slot (grows with the entity slots)
+ * @mem location_cap   = No of entries in `locations`
+ * @mem archetypes     = Every archetype created so far
+ * @mem arch_cnt       = No of archetypes
+ * @mem root           = Archetype of the entities without components
+ * @mem chunk_pool     = Pool of ISO_ARCH_CHUNK_SIZE chunks
+ */
+
+typedef struct {
+	iso_entity_allocator entities;
+	iso_arch_location* locations;
+	u32 location_cap;
+
+	iso_archetype** archetypes;
+	u32 arch_cnt;
+	iso_archetype* root;
+	iso_pool* chunk_pool;
+} iso_arch_ecs;
+
+
+/*
+ * @brief Function to create a new archetype ecs. Entity slots grow on demand.
+ * @param entity_cap = No of entity slots allocated up front
+ * @return Returns pointer to iso_arch_ecs struct
+ */
+
+static iso_arch_ecs* iso_arch_ecs_new(u32 entity_cap) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	iso_arch_ecs* ecs = iso_alloc(sizeof(iso_arch_ecs));
+	ecs->entities     = iso_entity_allocator_new(entity_cap);
+	ecs->locations    = iso_alloc(sizeof(iso_arch_location) * ecs->entities.cap);
+	ecs->location_cap = ecs->entities.cap;
+
+	ecs->chunk_pool = iso_pool_new((iso_pool_def) {
+		.name          = "iso_arch_chunk",
+		.obj_size      = ISO_ARCH_CHUNK_SIZE,
+		.objs_per_slab = 4
+	});
+
+	ecs->archetypes = iso_alloc(sizeof(iso_archetype*));
+	ecs->root = ecs->archetypes[ecs->arch_cnt++] = iso_archetype_new((iso_ecs_mask) { 0 });
+
+	iso_memory_pop_tag();
+	return ecs;
+}
+
+
+/*
+ * @brief Function to delete iso_arch_ecs
+ * @param ecs = Pointer to iso_arch_ecs struct
+ */
+
+static void iso_arch_ecs_delete(iso_arch_ecs* ecs) {
+	if (ecs->entities.entity_cnt) {
+		iso_log_warn("Not all the entities are deleted.\n");
+	}
+
+	for (u32 i = 0; i < ecs->arch_cnt; i++) {
+		iso_archetype_delete(ecs->archetypes[i], ecs->chunk_pool);
+	}
+	iso_free(ecs->archetypes);
+	iso_pool_delete(ecs->chunk_pool);
+	iso_entity_allocator_delete(&ecs->entities);
+	iso_free(ecs->locations);
+	iso_free(ecs);
+}
+
+
+/*
+ * @brief Internal function to find the archetype of a signature, creating it if needed
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param mask = Signature
+ * @return Returns pointer to the iso_archetype
+ */
+
+static iso_archetype* __iso_arch_ecs_get_archetype(iso_arch_ecs* ecs, iso_ecs_mask mask) {
+	for (u32 i = 0; i < ecs->arch_cnt; i++) {
+		if (iso_ecs_mask_eq(&ecs->archetypes[i]->mask, &mask)) return ecs->archetypes[i];
+	}
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	iso_archetype* arch = iso_archetype_new(mask);
+	ecs->archetypes = iso_realloc(ecs->archetypes, sizeof(iso_archetype*) * (ecs->arch_cnt + 1));
+	ecs->archetypes[ecs->arch_cnt++] = arch;
+	iso_memory_pop_tag();
+	return arch;
+}
+
+
+/*
+ * @brief Internal function to append a row for an entity to an archetype
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param arch = Pointer to iso_archetype
+ * @param ent  = iso_entity id
+ * @return Returns the location of the new row
+ */
+
+static iso_arch_location __iso_arch_alloc_row(iso_arch_ecs* ecs, iso_archetype* arch, iso_entity ent) {
+	iso_arch_chunk* chunk = arch->chunk_cnt ? arch->chunks[arch->chunk_cnt - 1] : NULL;
+
+	if (chunk == NULL || chunk->cnt == arch->chunk_cap) {
+		if (arch->chunk_cnt == arch->chunk_max) {
+			arch->chunk_max = arch->chunk_max ? arch->chunk_max * 2 : 4;
+			iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+			arch->chunks = iso_realloc(arch->chunks, sizeof(iso_arch_chunk*) * arch->chunk_max);
+			iso_memory_pop_tag();
+		}
+		chunk = iso_pool_alloc(ecs->chunk_pool);
+		arch->chunks[arch->chunk_cnt++] = chunk;
+	}
+
+	iso_arch_location loc = { arch, arch->chunk_cnt - 1, chunk->cnt++ };
+	iso_arch_chunk_entities(arch, chunk)[loc.row] = ent;
+	arch->entity_cnt++;
+	return loc;
+}
+
+
+/*
+ * @brief Internal function to remove a row from an archetype.
+ *        The last row of the archetype is moved into the hole to keep the chunks packed.
+ * @param ecs = Pointer to iso_arch_ecs
+ * @param loc = Location of the row
+ */
+
+static void __iso_arch_free_row(iso_arch_ecs* ecs, iso_arch_location loc) {
+	iso_archetype* arch = loc.arch;
+	iso_arch_chunk* chunk = arch->chunks[loc.chunk];
+	iso_arch_chunk* last_chunk = arch->chunks[arch->chunk_cnt - 1];
+	u32 last_row = last_chunk->cnt - 1;
+
+	if (chunk != last_chunk || loc.row != last_row) {
+		for (u32 c = 0; c < arch->comp_cnt; c++) {
+			u32 size = arch->sizes[c];
+			memcpy(iso_arch_chunk_column(arch, chunk, c) + loc.row * size,
+			       iso_arch_chunk_column(arch, last_chunk, c) + last_row * size, size);
+		}
+
+		iso_entity moved = iso_arch_chunk_entities(arch, last_chunk)[last_row];
+		iso_arch_chunk_entities(arch, chunk)[loc.row] = moved;
+		ecs->locations[iso_entity_index(moved)].chunk = loc.chunk;
+		ecs->locations[iso_entity_index(moved)].row   = loc.row;
+	}
+
+	// Giving emptied chunks back to the pool
+	if (--last_chunk->cnt == 0) {
+		iso_pool_free(ecs->chunk_pool, last_chunk);
+		arch->chunk_cnt--;
+	}
+	arch->entity_cnt--;
+}
+
+
+/*
+ * @brief Internal function to move an entity to another archetype.
+ *        Components present in both archetypes are copied, new ones are zeroed.
+ * @param ecs    = Pointer to iso_arch_ecs
+ * @param ent    = iso_entity id
+ * @param target = Archetype to move to
+ */
+
+static void __iso_arch_move(iso_arch_ecs* ecs, iso_entity ent, iso_archetype* target) {
+	iso_arch_location old_loc = ecs->locations[iso_entity_index(ent)];
+	iso_archetype* src = old_loc.arch;
+	iso_arch_chunk* src_chunk = src->chunks[old_loc.chunk];
+
+	iso_arch_location new_loc = __iso_arch_alloc_row(ecs, target, ent);
+	iso_arch_chunk* dst_chunk = target->chunks[new_loc.chunk];
+
+	for (u32 c = 0; c < target->comp_cnt; c++) {
+		u32 size = target->sizes[c];
+		u8* dst = iso_arch_chunk_column(target, dst_chunk, c) + new_loc.row * size;
+
+		i32 src_col = src->columns[target->type_ids[c]];
+		if (src_col >= 0) memcpy(dst, iso_arch_chunk_column(src, src_chunk, src_col) + old_loc.row * size, size);
+		else              memset(dst, 0, size);
+	}
+
+	__iso_arch_free_row(ecs, old_loc);
+	ecs->locations[iso_entity_index(ent)] = new_loc;
+}
+
+
+/*
+ * @brief Function to create new entity
+ * @param ecs = Pointer to iso_arch_ecs
+ * @return Returns a iso_entity type which is a entity id
+ */
+
+static iso_entity iso_arch_entity_new(iso_arch_ecs* ecs) {
+	iso_entity ent = iso_entity_allocator_create(&ecs->entities);
+
+	// Following the entity slots when the allocator grew
+	if (ecs->location_cap < ecs->entities.cap) {
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		ecs->locations    = iso_realloc(ecs->locations, sizeof(iso_arch_location) * ecs->entities.cap);
+		ecs->location_cap = ecs->entities.cap;
+		iso_memory_pop_tag();
+	}
+	ecs->locations[iso_entity_index(ent)] = __iso_arch_alloc_row(ecs, ecs->root, ent);
+	return ent;
+}
+
+
+/*
+ * @brief Function to delete an entity
+ * @param ecs = Pointer to the iso_arch_ecs
+ * @param ent = iso_entity id
+ */
+
+static void iso_arch_entity_delete(iso_arch_ecs* ecs, iso_entity ent) {
+	iso_assert(iso_entity_allocator_alive(&ecs->entities, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_arch_location loc = ecs->locations[iso_entity_index(ent)];
+	__iso_arch_destroy_rows(loc.arch, loc.arch->chunks[loc.chunk], loc.row, 1);
+	__iso_arch_free_row(ecs, loc);
+	ecs->locations[iso_entity_index(ent)].arch = NULL;
+	iso_entity_allocator_destroy(&ecs->entities, ent);
+}
+
+
+/*
+ * @brief Internal function to add component to entity
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @param data = Data of the component
+ * @param size = Size of the component
+ * @return Returns pointer to the component inside its chunk
+ */
+
+static void* __iso_arch_entity_add_component(iso_arch_ecs* ecs, iso_entity ent, u32 type, void* data, u32 size) {
+	iso_assert(iso_entity_allocator_alive(&ecs->entities, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_archetype* arch = ecs->locations[iso_entity_index(ent)].arch;
+	iso_assert(arch->columns[type] < 0, "Entity `%u` already has component `%s`.\n", iso_entity_index(ent), iso_ecs_type_name(type));
+
+	iso_archetype* target = arch->add_edges[type];
+	if (target == NULL) {
+		iso_ecs_mask mask = arch->mask;
+		iso_ecs_mask_set(&mask, type);
+		target = arch->add_edges[type] = __iso_arch_ecs_get_archetype(ecs, mask);
+		target->remove_edges[type] = arch;
+	}
+
+	__iso_arch_move(ecs, ent, target);
+
+	iso_arch_location loc = ecs->locations[iso_entity_index(ent)];
+	u8* comp = iso_arch_chunk_column(target, target->chunks[loc.chunk], target->columns[type]) + loc.row * size;
+	memcpy(comp, data, size);
+	return comp;
+}
+
+
+/*
+ * @brief Internal function to get the component from entity
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ * @return Returns pointer to the component data
+ */
+
+static void* __iso_arch_entity_get_component(iso_arch_ecs* ecs, iso_entity ent, u32 type) {
+	iso_assert(iso_entity_allocator_alive(&ecs->entities, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_arch_location loc = ecs->locations[iso_entity_index(ent)];
+	i32 col = loc.arch->columns[type];
+	iso_assert(col >= 0, "Entity `%u` doesnt have component `%s`.\n", iso_entity_index(ent), iso_ecs_type_name(type));
+
+	return iso_arch_chunk_column(loc.arch, loc.arch->chunks[loc.chunk], col) + loc.row * loc.arch->sizes[col];
+}
+
+
+/*
+ * @brief Internal function to remove component from entity
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param type = Type id of the component
+ */
+
+static void __iso_arch_entity_remove_component(iso_arch_ecs* ecs, iso_entity ent, u32 type) {
+	iso_assert(iso_entity_allocator_alive(&ecs->entities, ent), "Entity `%u` doesnt exists.\n", iso_entity_index(ent));
+
+	iso_archetype* arch = ecs->locations[iso_entity_index(ent)].arch;
+	iso_assert(arch->columns[type] >= 0, "Entity `%u` doesnt have component `%s`.\n", iso_entity_index(ent), iso_ecs_type_name(type));
+
+	iso_archetype* target = arch->remove_edges[type];
+	if (target == NULL) {
+		iso_ecs_mask mask = arch->mask;
+		iso_ecs_mask_clear(&mask, type);
+		target = arch->remove_edges[type] = __iso_arch_ecs_get_archetype(ecs, mask);
+		target->add_edges[type] = arch;
+	}
+
+	// The removed component is left behind by the move, it is destroyed first
+	iso_ecs_type_hooks* hooks = iso_ecs_get_type_hooks(type);
+	if (hooks->dtor) {
+		iso_arch_location loc = ecs->locations[iso_entity_index(ent)];
+		i32 col = arch->columns[type];
+		hooks->dtor(iso_arch_chunk_column(arch, arch->chunks[loc.chunk], col) + loc.row * arch->sizes[col], 1, arch->sizes[col]);
+	}
+
+	__iso_arch_move(ecs, ent, target);
+}
+
+
+/*
+ * @brief Macro to add a new component
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ * @param ...  = Component parameters
+ */
+
+#define iso_arch_entity_add_component(ecs, ent, comp, ...)                                \
+	({                                                                                      \
+		comp c = { __VA_ARGS__ };                                                             \
+		(comp*) __iso_arch_entity_add_component(ecs, ent, iso_ecs_type_id(comp), &c, sizeof(c)); \
+	})                                                                                      \
+
+
+/*
+ * @brief Macro to get a component
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_arch_entity_get_component(ecs, ent, comp)\
+	__iso_arch_entity_get_component(ecs, ent, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to remove a component
+ * @param ecs  = Pointer to iso_arch_ecs
+ * @param ent  = iso_entity id
+ * @param comp = Component structure
+ */
+
+#define iso_arch_entity_remove_component(ecs, ent, comp)\
+	__iso_arch_entity_remove_component(ecs, ent, iso_ecs_type_id(comp))
+
+
+/* =======================
+ * Archetype Query
+ * ======================= */
+
+
+/*
+ * @brief Iterator over the chunks of every archetype that matches the query
+ * @mem ecs      = Pointer to the iso_arch_ecs
+ * @mem with     = Component types that the archetypes must have
+ * @mem without  = Component types that the archetypes must not have
+ * @mem arch_idx = Index of the current archetype
+ * @mem chunk    = Index of the next chunk in the current archetype
+ * @mem arch     = Current archetype
+ * @mem data     = Current chunk
+ * @mem entities = Entities of the current chunk
+ * @mem cnt      = No of entities in the current chunk
+ */
+
+typedef struct {
+	iso_arch_ecs* ecs;
+	iso_ecs_mask with;
+	iso_ecs_mask without;
+
+	u32 arch_idx;
+	u32 chunk;
+	iso_archetype*  arch;
+	iso_arch_chunk* data;
+	iso_entity*     entities;
+	u32 cnt;
+} iso_arch_query;
+
+
+/*
+ * @brief Function to create a query. Add filters with iso_arch_query_with/without
+ *        and walk the chunks with iso_arch_query_next:
+ *          iso_arch_query q = iso_arch_query_new(ecs);
+ *          iso_arch_query_with(&q, pos);
+ *          while (iso_arch_query_next(&q)) {
+ *            pos* p = iso_arch_query_column(&q, pos);
+ *            for (u32 i = 0; i < q.cnt; i++) { p[i] ... }
+ *          }
+ * @param ecs = Pointer to iso_arch_ecs
+ * @return Returns the iso_arch_query
+ */
+
+static iso_arch_query iso_arch_query_new(iso_arch_ecs* ecs) {
+	return (iso_arch_query) { .ecs = ecs };
+}
+
+#define iso_arch_query_with(q, comp)\
+	iso_ecs_mask_set(&(q)->with, iso_ecs_type_id(comp))
+
+#define iso_arch_query_without(q, comp)\
+	iso_ecs_mask_set(&(q)->without, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Function to move the query to the next non-empty matching chunk
+ * @param q = Pointer to the iso_arch_query
+ * @return Returns false once every chunk was visited (the query restarts afterwards)
+ */
+
+static b8 iso_arch_query_next(iso_arch_query* q) {
+	iso_arch_ecs* ecs = q->ecs;
+
+	while (q->arch_idx < ecs->arch_cnt) {
+		iso_archetype* arch = ecs->archetypes[q->arch_idx];
+
+		b8 match = iso_ecs_mask_contains(&arch->mask, &q->with) && !iso_ecs_mask_intersects(&arch->mask, &q->without);
+
+		if (match && q->chunk < arch->chunk_cnt) {
+			q->arch     = arch;
+			q->data     = arch->chunks[q->chunk++];
+			q->entities = iso_arch_chunk_entities(arch, q->data);
+			q->cnt      = q->data->cnt;
+			return true;
+		}
+
+		q->arch_idx++;
+		q->chunk = 0;
+	}
+
+	q->arch_idx = 0;
+	q->chunk    = 0;
+	return false;
+}
+
+
+/*
+ * @brief Internal function to get a column of the current chunk of the query
+ * @param q    = Pointer to the iso_arch_query
+ * @param type = Type id of the component
+ * @return Returns pointer to the first component of the column
+ */
+
+static void* __iso_arch_query_column(iso_arch_query* q, u32 type) {
+	i32 col = q->arch->columns[type];
+	iso_assert(col >= 0, "Component `%s` is not part of the query.\n", iso_ecs_type_name(type));
+	return iso_arch_chunk_column(q->arch, q->data, col);
+}
+
+#define iso_arch_query_column(q, comp)\
+	((comp*) __iso_arch_query_column(q, iso_ecs_type_id(comp)))
+
+
+/*
+ * @brief Function run on a single chunk of a parallel query
+ * @param q    = Query positioned on the chunk (same fields as inside iso_arch_query_next)
+ * @param data = User data
+ */
+
+typedef void (*iso_arch_query_fn)(iso_arch_query* q, void* data);
+
+typedef struct {
+	iso_arch_query*   chunks;
+	iso_arch_query_fn fn;
+	void*             data;
+} __iso_arch_query_job;
+
+static void __iso_arch_query_job_run(void* data, u32 start, u32 end) {
+	__iso_arch_query_job* job = data;
+	for (u32 i = start; i < end; i++) {
+		job->fn(&job->chunks[i], job->data);
+	}
+}
+
+
+/*
+ * @brief Function to run a query with every matching chunk handed to a job of the thread pool
+ * @param q    = Pointer to iso_arch_query
+ * @param pool = Pointer to iso_thread_pool (NULL runs the chunks on the calling thread)
+ * @param fn   = Function called with every chunk
+ * @param data = User data passed to the function
+ */
+
+static void iso_arch_query_parallel_for(iso_arch_query* q, iso_thread_pool* pool, iso_arch_query_fn fn, void* data) {
+	u32 chunk_cnt = 0;
+	for (u32 i = 0; i < q->ecs->arch_cnt; i++) {
+		chunk_cnt += q->ecs->archetypes[i]->chunk_cnt;
+	}
+	if (chunk_cnt == 0) return;
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	iso_arch_query* chunks = iso_alloc_uninit(sizeof(iso_arch_query) * chunk_cnt);
+	iso_memory_pop_tag();
+
+	u32 cnt = 0;
+	while (iso_arch_query_next(q)) {
+		chunks[cnt++] = *q;
+	}
+
+	__iso_arch_query_job job = { chunks, fn, data };
+	iso_thread_pool_parallel_for(pool, cnt, 1, __iso_arch_query_job_run, &job);
+	iso_free(chunks);
+}
+
+#endif // __ISO_ECS_ARCHETYPE_H__
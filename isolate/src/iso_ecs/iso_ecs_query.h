@@ -0,0 +1,698 @@
+#ifndef __ISO_ECS_QUERY_H__
+#define __ISO_ECS_QUERY_H__
+
+#include "iso_util/iso_includes.h"
+#include "iso_util/iso_defines.h"
+#include "iso_util/iso_memory.h"
+#include "iso_ecs.h"
+
+/*
+ * Query
+ *
+ * Iterates every entity of an iso_ecs that has all the `with` components and
+ * none of the `without` components:
+ *
+ *   iso_ecs_query q = iso_ecs_query_new(ecs);
+ *   iso_ecs_query_with(&q, pos);
+ *   iso_ecs_query_with(&q, vel);
+ *   iso_ecs_query_without(&q, frozen);
+ *
+ *   while (iso_ecs_query_next(&q)) {
+ *     pos* p = iso_ecs_query_get(&q, pos);
+ *     vel* v = iso_ecs_query_get(&q, vel);
+ *     ...
+ *   }
+ *   iso_ecs_query_delete(&q);
+ *
+ * Adding iso_ecs_query_changed(&q, pos) or iso_ecs_query_added(&q, pos) only
+ * visits entities whose component was written (iso_ecs_query_get_mut and
+ * iso_entity_get_component_mut) or added since the previous run of the query.
+ *
+ * The record with the fewest entries drives the iteration. Every entity it
+ * visits is matched by comparing its signature against the masks of the query,
+ * and only the matches are looked up in the other records.
+ * When a `with` tag has fewer entries than every component with data, the tag
+ * bitsets drive instead: the `with` tags are and-ed and the `without` tags
+ * masked out a word (64 entity slots) at a time, and only the set bits are matched. A cached query keeps the
+ * matched rows between runs and only rebuilds them when one of its records changed.
+ */
+
+// Max amount of `with` and of `without` components of a query
+#define ISO_ECS_QUERY_MAX_TERMS 8
+
+
+/*
+ * @brief Query over the components of an iso_ecs
+ * @mem ecs           = Pointer to the iso_ecs
+ * @mem with          = Type ids the entities must have
+ * @mem with_cnt      = No of `with` types
+ * @mem without       = Type ids the entities must not have
+ * @mem without_cnt   = No of `without` types
+ * @mem with_mask     = Mask of the `with` types
+ * @mem without_mask  = Mask of the `without` types
+ * @mem word_first    = First word of the masks with a type set
+ * @mem word_end      = End of the words of the masks with a type set
+ * @mem changed_terms = Bits of the `with` terms that must have changed since the last run
+ * @mem added_terms   = Bits of the `with` terms that must have been added since the last run
+ * @mem since         = Tick of the previous run, compared against the ticks of the components
+ * @mem last_tick     = Tick of the current run
+ * @mem cached        = Whether the matches are kept between runs
+ * @mem entity        = Current entity
+ * @mem comps         = Components of the current entity, in the order of `with`
+ * @mem rows          = Dense indices of the components of the current entity
+ * @mem recs          = Records of the `with` types
+ * @mem driver        = Index in `with` of the record that drives the iteration
+ * @mem tag_terms     = Bits of the `with` terms that are tags
+ * @mem tag_driven    = Whether the tag bitsets drive the iteration instead of `driver`
+ * @mem tag_word_end  = No of words of the tag bitsets to scan
+ * @mem tag_excl      = Records of the `without` types that are tags
+ * @mem tag_excl_cnt  = No of records in `tag_excl`
+ * @mem tag_word      = Bits of the current word of the tag bitsets left to visit
+ * @mem idx           = Position of the iteration (next word when tag driven)
+ * @mem active        = Whether an iteration is in progress
+ * @mem cache_valid   = Whether the cache was built
+ * @mem versions      = Record versions the cache was built with (`with` then `without`)
+ * @mem match_cnt     = No of cached matches
+ * @mem match_cap     = Capacity of the cache
+ * @mem match_ents    = Cached entities
+ * @mem match_rows    = Cached dense indices of the `with` components (`with_cnt` per match)
+ */
+
+typedef struct {
+	iso_ecs* ecs;
+	u32 with[ISO_ECS_QUERY_MAX_TERMS];
+	u32 with_cnt;
+	u32 without[ISO_ECS_QUERY_MAX_TERMS];
+	u32 without_cnt;
+	iso_ecs_mask with_mask;
+	iso_ecs_mask without_mask;
+	u32 word_first;
+	u32 word_end;
+	u32 changed_terms;
+	u32 added_terms;
+	u32 since;
+	u32 last_tick;
+	b8  cached;
+
+	iso_entity entity;
+	void* comps[ISO_ECS_QUERY_MAX_TERMS];
+	u32   rows[ISO_ECS_QUERY_MAX_TERMS];
+
+	iso_comp_record* recs[ISO_ECS_QUERY_MAX_TERMS];
+	u32 driver;
+	u32 tag_terms;
+	b8  tag_driven;
+	u32 tag_word_end;
+	iso_comp_record* tag_excl[ISO_ECS_QUERY_MAX_TERMS];
+	u32 tag_excl_cnt;
+	u64 tag_word;
+	u32 idx;
+	b8  active;
+
+	b8  cache_valid;
+	u32 versions[ISO_ECS_QUERY_MAX_TERMS * 2];
+	u32 match_cnt;
+	u32 match_cap;
+	iso_entity* match_ents;
+	u32* match_rows;
+} iso_ecs_query;
+
+
+/*
+ * @brief Function to create a query
+ * @param ecs = Pointer to iso_ecs
+ * @return Returns the iso_ecs_query
+ */
+
+static iso_ecs_query iso_ecs_query_new(iso_ecs* ecs) {
+	return (iso_ecs_query) { .ecs = ecs };
+}
+
+
+/*
+ * @brief Function to delete the cache of a query
+ * @param q = Pointer to iso_ecs_query
+ */
+
+static void iso_ecs_query_delete(iso_ecs_query* q) {
+	iso_free(q->match_ents);
+	iso_free(q->match_rows);
+	q->match_ents = NULL;
+	q->match_rows = NULL;
+	q->match_cnt = q->match_cap = 0;
+	q->cache_valid = false;
+}
+
+
+/*
+ * @brief Internal function to add a `with` component to the query
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ */
+
+static void __iso_ecs_query_with(iso_ecs_query* q, u32 type) {
+	iso_assert(q->with_cnt < ISO_ECS_QUERY_MAX_TERMS, "Query has too many `with` components.\n");
+	q->with[q->with_cnt++] = type;
+	iso_ecs_mask_set(&q->with_mask, type);
+	q->cache_valid = false;
+}
+
+
+/*
+ * @brief Internal function to add a `without` component to the query
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ */
+
+static void __iso_ecs_query_without(iso_ecs_query* q, u32 type) {
+	iso_assert(q->without_cnt < ISO_ECS_QUERY_MAX_TERMS, "Query has too many `without` components.\n");
+	q->without[q->without_cnt++] = type;
+	iso_ecs_mask_set(&q->without_mask, type);
+	q->cache_valid = false;
+}
+
+
+/*
+ * @brief Internal function to get the position of a type in the `with` list, adding it if needed
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ * @return Returns the position in `with`
+ */
+
+static u32 __iso_ecs_query_term(iso_ecs_query* q, u32 type) {
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		if (q->with[i] == type) return i;
+	}
+	__iso_ecs_query_with(q, type);
+	return q->with_cnt - 1;
+}
+
+
+/*
+ * @brief Internal function to only match entities whose component changed since the last run
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ */
+
+static void __iso_ecs_query_changed(iso_ecs_query* q, u32 type) {
+	q->changed_terms |= 1u << __iso_ecs_query_term(q, type);
+}
+
+
+/*
+ * @brief Internal function to only match entities whose component was added since the last run
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ */
+
+static void __iso_ecs_query_added(iso_ecs_query* q, u32 type) {
+	q->added_terms |= 1u << __iso_ecs_query_term(q, type);
+}
+
+
+/*
+ * @brief Function to keep the matches of the query between runs. The cache is rebuilt
+ *        when any of the records of the query had components added or removed.
+ * @param q      = Pointer to iso_ecs_query
+ * @param cached = Enable or disable the cache
+ */
+
+static void iso_ecs_query_set_cached(iso_ecs_query* q, b8 cached) {
+	q->cached = cached;
+	if (!cached) iso_ecs_query_delete(q);
+}
+
+
+/*
+ * @brief Internal function to check an entity of the driving record against the query.
+ *        Fills `comps` and `rows` (if not NULL) with the dense indices of the `with` components.
+ * @param q          = Pointer to iso_ecs_query
+ * @param ent        = iso_entity to check
+ * @param driver_row = Dense index of the entity in the driving record
+ * @param rows       = Output of the dense indices (can be NULL)
+ * @return Returns true if the entity matches
+ */
+
+static b8 __iso_ecs_query_match(iso_ecs_query* q, iso_entity ent, u32 driver_row, u32* rows) {
+	u32 id = iso_entity_index(ent);
+
+	// Comparing only the words of the signature the query cares about
+	u64* sig = q->ecs->signatures[id].bits;
+	u64 miss = 0;
+	for (u32 w = q->word_first; w < q->word_end; w++) {
+		miss |= (q->with_mask.bits[w] & ~sig[w]) | (q->without_mask.bits[w] & sig[w]);
+	}
+	if (miss) return false;
+
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		iso_comp_record* rec = q->recs[i];
+		u32 row = i == q->driver ? driver_row : rec->tag ? 0 : iso_comp_record_sparse_get(rec, id);
+
+		q->comps[i] = rec->data + (size_t) row * rec->size;
+		q->rows[i]  = row;
+		if (rows) rows[i] = row;
+	}
+
+	return true;
+}
+
+
+/*
+ * @brief Internal function to check the `changed` and `added` terms of the current entity
+ * @param q = Pointer to iso_ecs_query
+ * @return Returns true if the entity passes the filters
+ */
+
+static b8 __iso_ecs_query_filter(iso_ecs_query* q) {
+	for (u32 bits = q->changed_terms; bits; bits &= bits - 1) {
+		u32 i = __builtin_ctz(bits);
+		if (!iso_ecs_tick_newer(q->recs[i]->changed[q->rows[i]], q->since)) return false;
+	}
+	for (u32 bits = q->added_terms; bits; bits &= bits - 1) {
+		u32 i = __builtin_ctz(bits);
+		if (!iso_ecs_tick_newer(q->recs[i]->added[q->rows[i]], q->since)) return false;
+	}
+	return true;
+}
+
+
+/*
+ * @brief Internal function to get the version of a record (0 if it doesnt exist yet)
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the record
+ * @return Returns the version of the record
+ */
+
+static u32 __iso_ecs_query_record_version(iso_ecs_query* q, u32 type) {
+	iso_comp_record* rec = q->ecs->table->records[type];
+	return rec ? rec->version : 0;
+}
+
+
+/*
+ * @brief Internal function to get the next entity slot set in every `with` tag bitset
+ *        and in none of the `without` tag bitsets
+ * @param q    = Pointer to iso_ecs_query
+ * @param word = Position of the next word to load, advanced by the scan
+ * @param bits = Bits of the current word left to visit, updated by the scan
+ * @param ent  = Output of the entity of the slot
+ * @return Returns false once every word was scanned
+ */
+
+static b8 __iso_ecs_query_scan_tags(iso_ecs_query* q, u32* word, u64* bits, iso_entity* ent) {
+	while (*bits == 0) {
+		if (*word >= q->tag_word_end) return false;
+
+		u32 w = (*word)++;
+		u64 b = ~0ull;
+		for (u32 t = q->tag_terms; t; t &= t - 1) {
+			b &= q->recs[__builtin_ctz(t)]->tags[w];
+		}
+		for (u32 i = 0; i < q->tag_excl_cnt && b; i++) {
+			iso_comp_record* rec = q->tag_excl[i];
+			if (w < rec->tag_words) b &= ~rec->tags[w];
+		}
+		*bits = b;
+	}
+
+	u32 id = (*word - 1) * 64 + __builtin_ctzll(*bits);
+	*bits &= *bits - 1;
+	*ent = iso_entity_make(id, q->ecs->entities.versions[id]);
+	return true;
+}
+
+
+/*
+ * @brief Internal function to rebuild the cached matches of the query
+ * @param q = Pointer to iso_ecs_query
+ */
+
+static void __iso_ecs_query_build_cache(iso_ecs_query* q) {
+	iso_comp_record* driver = q->tag_driven ? NULL : q->recs[q->driver];
+	u32 cap = driver ? driver->entry_cnt : (u32) -1;
+	for (u32 t = q->tag_driven ? q->tag_terms : 0; t; t &= t - 1) {
+		if (q->recs[__builtin_ctz(t)]->entry_cnt < cap) cap = q->recs[__builtin_ctz(t)]->entry_cnt;
+	}
+
+	if (q->match_cap < cap) {
+		q->match_cap = cap;
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		q->match_ents = iso_realloc(q->match_ents, sizeof(iso_entity) * q->match_cap);
+		q->match_rows = iso_realloc(q->match_rows, sizeof(u32) * q->match_cap * ISO_ECS_QUERY_MAX_TERMS);
+		iso_memory_pop_tag();
+	}
+
+	q->match_cnt = 0;
+	if (q->tag_driven) {
+		u32 word = 0;
+		u64 bits = 0;
+		iso_entity ent;
+		while (__iso_ecs_query_scan_tags(q, &word, &bits, &ent)) {
+			if (__iso_ecs_query_match(q, ent, ISO_COMP_RECORD_INVALID, q->match_rows + q->match_cnt * q->with_cnt)) {
+				q->match_ents[q->match_cnt++] = ent;
+			}
+		}
+	} else {
+		for (u32 i = 0; i < driver->entry_cnt; i++) {
+			iso_entity ent = driver->entities[i];
+			if (__iso_ecs_query_match(q, ent, i, q->match_rows + q->match_cnt * q->with_cnt)) {
+				q->match_ents[q->match_cnt++] = ent;
+			}
+		}
+	}
+
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		q->versions[i] = __iso_ecs_query_record_version(q, q->with[i]);
+	}
+	for (u32 i = 0; i < q->without_cnt; i++) {
+		q->versions[q->with_cnt + i] = __iso_ecs_query_record_version(q, q->without[i]);
+	}
+	q->cache_valid = true;
+}
+
+
+/*
+ * @brief Internal function to start an iteration of the query
+ * @param q = Pointer to iso_ecs_query
+ * @return Returns false if the query cant match any entity
+ */
+
+static b8 __iso_ecs_query_begin(iso_ecs_query* q) {
+	iso_assert(q->with_cnt > 0, "Query needs at least one `with` component.\n");
+
+	q->word_first = ISO_ECS_MASK_WORDS;
+	q->word_end   = 0;
+	for (u32 w = 0; w < ISO_ECS_MASK_WORDS; w++) {
+		if ((q->with_mask.bits[w] | q->without_mask.bits[w]) == 0) continue;
+		if (q->word_first > w) q->word_first = w;
+		q->word_end = w + 1;
+	}
+
+	u32 filtered = q->changed_terms | q->added_terms;
+	q->tag_terms = 0;
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		q->recs[i] = q->ecs->table->records[q->with[i]];
+		if (q->recs[i] == NULL) return false;
+		if (q->recs[i]->tag) q->tag_terms |= 1u << i;
+	}
+	iso_assert((filtered & q->tag_terms) == 0, "Tags dont have `changed` and `added` ticks.\n");
+
+	// Picking the smallest record to drive the iteration, a filtered one if there are any
+	// so that chunks without changes can be skipped
+	u32 all     = (1u << q->with_cnt) - 1;
+	u32 drivers = filtered ? filtered : all & ~q->tag_terms;
+	u32 tag_cnt = (u32) -1;
+	q->driver = drivers ? __builtin_ctz(drivers) : q->with_cnt;
+	q->tag_word_end = (u32) -1;
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		iso_comp_record* rec = q->recs[i];
+		if (rec->tag) {
+			if (rec->entry_cnt < tag_cnt) tag_cnt = rec->entry_cnt;
+			if (rec->tag_words < q->tag_word_end) q->tag_word_end = rec->tag_words;
+		} else if ((drivers >> i) & 1 && rec->entry_cnt < q->recs[q->driver]->entry_cnt) {
+			q->driver = i;
+		}
+	}
+
+	// Scanning the tag bitsets when they have fewer entries than every record with data
+	q->tag_driven = !filtered && q->tag_terms && (drivers == 0 || tag_cnt < q->recs[q->driver]->entry_cnt);
+	if (q->tag_driven) {
+		q->driver = q->with_cnt;
+		q->tag_word = 0;
+		q->tag_excl_cnt = 0;
+		for (u32 i = 0; i < q->without_cnt; i++) {
+			iso_comp_record* rec = q->ecs->table->records[q->without[i]];
+			if (rec && rec->tag) q->tag_excl[q->tag_excl_cnt++] = rec;
+		}
+	}
+
+	// Changes stamped from now on are newer than this run
+	if (filtered) {
+		q->since = q->last_tick;
+		q->last_tick = __atomic_fetch_add(&q->ecs->table->tick, 1, __ATOMIC_RELAXED);
+	}
+
+	if (q->cached) {
+		b8 stale = !q->cache_valid;
+		for (u32 i = 0; i < q->with_cnt && !stale; i++) {
+			stale = q->versions[i] != q->recs[i]->version;
+		}
+		for (u32 i = 0; i < q->without_cnt && !stale; i++) {
+			stale = q->versions[q->with_cnt + i] != __iso_ecs_query_record_version(q, q->without[i]);
+		}
+		if (stale) __iso_ecs_query_build_cache(q);
+	}
+
+	q->idx = 0;
+	q->active = true;
+	return true;
+}
+
+
+/*
+ * @brief Function to move the query to the next matching entity
+ * @param q = Pointer to iso_ecs_query
+ * @return Returns false once every match was visited (the query restarts afterwards)
+ */
+
+static b8 iso_ecs_query_next(iso_ecs_query* q) {
+	if (!q->active && !__iso_ecs_query_begin(q)) return false;
+
+	b8 filtered = (q->changed_terms | q->added_terms) != 0;
+
+	if (q->cached) {
+		while (q->idx < q->match_cnt) {
+			u32* rows = q->match_rows + q->idx * q->with_cnt;
+			for (u32 i = 0; i < q->with_cnt; i++) {
+				q->rows[i]  = rows[i];
+				q->comps[i] = q->recs[i]->data + (size_t) rows[i] * q->recs[i]->size;
+			}
+			q->entity = q->match_ents[q->idx++];
+			if (!filtered || __iso_ecs_query_filter(q)) return true;
+		}
+	} else if (q->tag_driven) {
+		iso_entity ent;
+		while (__iso_ecs_query_scan_tags(q, &q->idx, &q->tag_word, &ent)) {
+			if (__iso_ecs_query_match(q, ent, ISO_COMP_RECORD_INVALID, NULL)) {
+				q->entity = ent;
+				return true;
+			}
+		}
+	} else {
+		iso_comp_record* driver = q->recs[q->driver];
+		b8 skip_chunks = ((q->changed_terms | q->added_terms) >> q->driver) & 1;
+
+		while (q->idx < driver->entry_cnt) {
+			u32 row = q->idx++;
+
+			// Skipping whole chunks of the driving record that didnt change since the last run
+			if (skip_chunks && (row & (ISO_COMP_RECORD_TICK_CHUNK - 1)) == 0
+			    && !iso_ecs_tick_newer(driver->chunks[row >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT], q->since)) {
+				q->idx = row + ISO_COMP_RECORD_TICK_CHUNK;
+				continue;
+			}
+
+			iso_entity ent = driver->entities[row];
+			if (__iso_ecs_query_match(q, ent, row, NULL) && (!filtered || __iso_ecs_query_filter(q))) {
+				q->entity = ent;
+				return true;
+			}
+		}
+	}
+
+	q->active = false;
+	return false;
+}
+
+
+/*
+ * @brief Internal function to get a component of the current entity
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ * @return Returns pointer to the component
+ */
+
+static void* __iso_ecs_query_get(iso_ecs_query* q, u32 type) {
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		if (q->with[i] == type) {
+			iso_assert(!q->recs[i]->tag, "Component `%s` is a tag and has no data.\n", q->recs[i]->name);
+			return q->comps[i];
+		}
+	}
+	iso_assert(false, "Component `%s` is not part of the query.\n", iso_ecs_type_name(type));
+	return NULL;
+}
+
+
+/*
+ * @brief Internal function to get a component of the current entity and stamp it as changed
+ * @param q    = Pointer to iso_ecs_query
+ * @param type = Type id of the component
+ * @return Returns pointer to the component
+ */
+
+static void* __iso_ecs_query_get_mut(iso_ecs_query* q, u32 type) {
+	for (u32 i = 0; i < q->with_cnt; i++) {
+		if (q->with[i] == type) {
+			iso_assert(!q->recs[i]->tag, "Component `%s` is a tag and has no data.\n", q->recs[i]->name);
+			iso_comp_record_mark_changed(q->recs[i], q->rows[i]);
+			return q->comps[i];
+		}
+	}
+	iso_assert(false, "Component `%s` is not part of the query.\n", iso_ecs_type_name(type));
+	return NULL;
+}
+
+
+/*
+ * @brief Macro to add a component the entities must have
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_with(q, comp)\
+	__iso_ecs_query_with(q, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to add a component the entities must not have
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_without(q, comp)\
+	__iso_ecs_query_without(q, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to get a component of the current entity. Same as q->comps[i]
+ *        where i is the position of the component in the `with` list.
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_get(q, comp)\
+	((comp*) __iso_ecs_query_get(q, iso_ecs_type_id(comp)))
+
+
+/*
+ * @brief Macro to get a component of the current entity that is going to be written.
+ *        The component is stamped as changed for queries using iso_ecs_query_changed.
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_get_mut(q, comp)\
+	((comp*) __iso_ecs_query_get_mut(q, iso_ecs_type_id(comp)))
+
+
+/*
+ * @brief Macro to only match entities whose component was written since the previous
+ *        run of the query. Adds the component to the `with` list if needed.
+ *        The first run matches every entity.
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_changed(q, comp)\
+	__iso_ecs_query_changed(q, iso_ecs_type_id(comp))
+
+
+/*
+ * @brief Macro to only match entities that got the component since the previous
+ *        run of the query. Adds the component to the `with` list if needed.
+ * @param q    = Pointer to iso_ecs_query
+ * @param comp = Component structure
+ */
+
+#define iso_ecs_query_added(q, comp)\
+	__iso_ecs_query_added(q, iso_ecs_type_id(comp))
+
+
+/* =======================
+ * Parallel Query
+ * ======================= */
+
+
+/*
+ * @brief Function run on a range of the matches of a query
+ * @param q     = Pointer to the iso_ecs_query (read only, use iso_ecs_query_at)
+ * @param start = First match of the range
+ * @param end   = End of the range (exclusive)
+ * @param data  = User data
+ */
+
+typedef void (*iso_ecs_query_fn)(iso_ecs_query* q, u32 start, u32 end, void* data);
+
+typedef struct {
+	iso_ecs_query*   q;
+	iso_ecs_query_fn fn;
+	void*            data;
+} __iso_ecs_query_job;
+
+static void __iso_ecs_query_job_run(void* data, u32 start, u32 end) {
+	__iso_ecs_query_job* job = data;
+	job->fn(job->q, start, end, job->data);
+}
+
+
+/*
+ * @brief Function to split the matches of a query in batches and run them on the
+ *        thread pool of the ecs. The matches are resolved through the query cache,
+ *        so the query is cached afterwards:
+ *          void integrate(iso_ecs_query* q, u32 start, u32 end, void* data) {
+ *            for (u32 i = start; i < end; i++) {
+ *              pos* p = iso_ecs_query_at(q, i, 0);
+ *              vel* v = iso_ecs_query_at(q, i, 1);
+ *            }
+ *          }
+ *          iso_ecs_query_parallel_for(&q, 0, integrate, NULL);
+ * @param q     = Pointer to iso_ecs_query
+ * @param batch = No of matches per job (0 to split the matches evenly between the threads)
+ * @param fn    = Function called with every batch
+ * @param data  = User data passed to the function
+ */
+
+static void iso_ecs_query_parallel_for(iso_ecs_query* q, u32 batch, iso_ecs_query_fn fn, void* data) {
+	iso_assert((q->changed_terms | q->added_terms) == 0, "Parallel queries dont support `changed` and `added` filters.\n");
+	q->cached = true;
+	if (!__iso_ecs_query_begin(q)) return;
+	q->active = false;
+
+	__iso_ecs_query_job job = { q, fn, data };
+	iso_thread_pool_parallel_for(q->ecs->pool, q->match_cnt, batch, __iso_ecs_query_job_run, &job);
+}
+
+
+/*
+ * @brief Function to get a component of a cached match
+ * @param q    = Pointer to iso_ecs_query
+ * @param i    = Index of the match
+ * @param term = Position of the component in the `with` list
+ * @return Returns pointer to the component
+ */
+
+static void* iso_ecs_query_at(iso_ecs_query* q, u32 i, u32 term) {
+	iso_comp_record* rec = q->recs[term];
+	iso_assert(!rec->tag, "Component `%s` is a tag and has no data.\n", rec->name);
+	return rec->data + (size_t) q->match_rows[i * q->with_cnt + term] * rec->size;
+}
+
+
+/*
+ * @brief Function to get a component of a cached match that is going to be written
+ * @param q    = Pointer to iso_ecs_query
+ * @param i    = Index of the match
+ * @param term = Position of the component in the `with` list
+ * @return Returns pointer to the component
+ */
+
+static void* iso_ecs_query_at_mut(iso_ecs_query* q, u32 i, u32 term) {
+	iso_comp_record* rec = q->recs[term];
+	iso_assert(!rec->tag, "Component `%s` is a tag and has no data.\n", rec->name);
+	u32 row = q->match_rows[i * q->with_cnt + term];
+	iso_comp_record_mark_changed(rec, row);
+	return rec->data + (size_t) row * rec->size;
+}
+
+#endif // __ISO_ECS_QUERY_H__
@@ -0,0 +1,301 @@
+#include "iso_ecs_snapshot.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+#endif
+
+/*
+ * @brief Destination of a snapshot being written
+ * @mem buf  = Memory the snapshot is written to (NULL when writing to `file`)
+ * @mem file = File the snapshot is written to
+ * @mem pos  = No of bytes written so far
+ */
+
+typedef struct {
+	u8*   buf;
+	FILE* file;
+	u64   pos;
+} __iso_ecs_snapshot_writer;
+
+static u64 __iso_ecs_snapshot_align(u64 offset) {
+	return (offset + ISO_ECS_SNAPSHOT_ALIGN - 1) & ~((u64) ISO_ECS_SNAPSHOT_ALIGN - 1);
+}
+
+/*
+ * @brief Writes `size` bytes at `offset`, zero filling the gap since the last write
+ */
+
+static void __iso_ecs_snapshot_emit(__iso_ecs_snapshot_writer* w, u64 offset, void* data, u64 size) {
+	static const u8 zeros[ISO_ECS_SNAPSHOT_ALIGN];
+
+	while (w->pos < offset) {
+		u64 pad = offset - w->pos < ISO_ECS_SNAPSHOT_ALIGN ? offset - w->pos : ISO_ECS_SNAPSHOT_ALIGN;
+		if (w->buf) memset(w->buf + w->pos, 0, pad);
+		else        fwrite(zeros, 1, pad, w->file);
+		w->pos += pad;
+	}
+
+	if (size == 0) return;
+	if (w->buf) memcpy(w->buf + w->pos, data, size);
+	else        iso_assert(fwrite(data, 1, size, w->file) == size, "Failed to write snapshot.\n[Reason]: %s\n", strerror(errno));
+	w->pos += size;
+}
+
+/*
+ * @brief Size of the bitset of a tag record, one bit per entity slot
+ */
+
+static u64 __iso_ecs_snapshot_tag_size(iso_ecs_snapshot_header* header) {
+	return sizeof(u64) * (((u64) header->entity_cap + 63) / 64);
+}
+
+/*
+ * @brief Computes where every array of the ecs goes in the snapshot
+ * @param ecs    = Pointer to iso_ecs
+ * @param header = Header to fill
+ * @param recs   = Record schemas to fill (one per record of the table, NULL to only get the size)
+ * @return Returns the size of the snapshot
+ */
+
+static u64 __iso_ecs_snapshot_layout(iso_ecs* ecs, iso_ecs_snapshot_header* header, iso_ecs_snapshot_record* recs) {
+	iso_comp_table* table = ecs->table;
+
+	*header = (iso_ecs_snapshot_header) {
+		.magic      = ISO_ECS_SNAPSHOT_MAGIC,
+		.version    = ISO_ECS_SNAPSHOT_VERSION,
+		.entity_cap = ecs->entities.cap,
+		.entity_cnt = ecs->entities.entity_cnt,
+		.free_cnt   = ecs->entities.free_cnt,
+		.record_cnt = table->record_cnt,
+		.tick       = table->tick
+	};
+
+	u64 offset = sizeof(iso_ecs_snapshot_header) + sizeof(iso_ecs_snapshot_record) * table->record_cnt;
+	header->versions = offset = __iso_ecs_snapshot_align(offset);
+	offset += sizeof(u32) * header->entity_cap;
+	header->free_ids = offset = __iso_ecs_snapshot_align(offset);
+	offset += sizeof(u32) * header->free_cnt;
+
+	for (u32 i = 0; i < table->record_cnt; i++) {
+		iso_comp_record* rec = table->records[table->record_types[i]];
+		u64 cnt = rec->tag ? 0 : rec->entry_cnt;
+
+		iso_ecs_snapshot_record desc = { 0 };
+		strncpy(desc.name, rec->name, ISO_ECS_TYPE_NAME_SIZE - 1);
+		desc.type_size = iso_ecs_type_size(rec->type);
+		desc.size      = rec->size;
+		desc.align     = rec->align;
+		desc.entry_cnt = rec->entry_cnt;
+
+		desc.entities = offset = __iso_ecs_snapshot_align(offset);
+		offset += sizeof(iso_entity) * cnt;
+		desc.data     = offset = __iso_ecs_snapshot_align(offset);
+		offset += rec->tag ? __iso_ecs_snapshot_tag_size(header) : rec->size * cnt;
+		desc.added    = offset = __iso_ecs_snapshot_align(offset);
+		offset += sizeof(u32) * cnt;
+		desc.changed  = offset = __iso_ecs_snapshot_align(offset);
+		offset += sizeof(u32) * cnt;
+		desc.chunks   = offset = __iso_ecs_snapshot_align(offset);
+		offset += sizeof(u32) * ((cnt + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT);
+
+		if (recs) recs[i] = desc;
+	}
+
+	header->size = offset;
+	return offset;
+}
+
+/*
+ * @brief Writes the whole snapshot of the ecs through the writer
+ */
+
+static void __iso_ecs_snapshot_write(iso_ecs* ecs, __iso_ecs_snapshot_writer* w) {
+	iso_comp_table* table = ecs->table;
+	iso_ecs_snapshot_header header;
+	iso_ecs_snapshot_record recs[ISO_ECS_MAX_TYPES];
+	__iso_ecs_snapshot_layout(ecs, &header, recs);
+
+	__iso_ecs_snapshot_emit(w, 0, &header, sizeof(header));
+	__iso_ecs_snapshot_emit(w, w->pos, recs, sizeof(iso_ecs_snapshot_record) * header.record_cnt);
+	__iso_ecs_snapshot_emit(w, header.versions, ecs->entities.versions, sizeof(u32) * header.entity_cap);
+	__iso_ecs_snapshot_emit(w, header.free_ids, ecs->entities.free_ids, sizeof(u32) * header.free_cnt);
+
+	for (u32 i = 0; i < header.record_cnt; i++) {
+		iso_comp_record* rec = table->records[table->record_types[i]];
+		iso_ecs_snapshot_record* desc = &recs[i];
+		u64 cnt = rec->tag ? 0 : desc->entry_cnt;
+
+		// The bitset of a tag can be shorter than the entity slots, the rest is zero filled
+		u64 tag_size = (u64) rec->tag_words * sizeof(u64);
+		if (tag_size > __iso_ecs_snapshot_tag_size(&header)) tag_size = __iso_ecs_snapshot_tag_size(&header);
+
+		__iso_ecs_snapshot_emit(w, desc->entities, rec->entities, sizeof(iso_entity) * cnt);
+		if (rec->tag) __iso_ecs_snapshot_emit(w, desc->data, rec->tags, tag_size);
+		else          __iso_ecs_snapshot_emit(w, desc->data, rec->data, (u64) rec->size * cnt);
+		__iso_ecs_snapshot_emit(w, desc->added,    rec->added, sizeof(u32) * cnt);
+		__iso_ecs_snapshot_emit(w, desc->changed,  rec->changed, sizeof(u32) * cnt);
+		__iso_ecs_snapshot_emit(w, desc->chunks,   rec->chunks, sizeof(u32) * ((cnt + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT));
+	}
+	__iso_ecs_snapshot_emit(w, header.size, NULL, 0);
+}
+
+size_t iso_ecs_snapshot_size(iso_ecs* ecs) {
+	iso_ecs_snapshot_header header;
+	return __iso_ecs_snapshot_layout(ecs, &header, NULL);
+}
+
+void iso_ecs_snapshot_write_buffer(iso_ecs* ecs, void* buf) {
+	__iso_ecs_snapshot_writer w = { .buf = buf };
+	__iso_ecs_snapshot_write(ecs, &w);
+}
+
+void iso_ecs_snapshot_write(iso_ecs* ecs, char* path) {
+	FILE* f = fopen(path, "wb");
+	if (!f) {
+		iso_assert(false, "Failed to open file: %s\n[Reason]: %s\n", path, strerror(errno));
+	}
+
+	__iso_ecs_snapshot_writer w = { .file = f };
+	__iso_ecs_snapshot_write(ecs, &w);
+	fclose(f);
+}
+
+/*
+ * @brief Checks that an array of the snapshot lies inside of it
+ */
+
+static void __iso_ecs_snapshot_check(iso_ecs_snapshot_header* header, u64 offset, u64 size) {
+	iso_assert(offset <= header->size && size <= header->size - offset, "Snapshot is corrupted.\n");
+}
+
+void iso_ecs_snapshot_load_buffer(iso_ecs* ecs, void* buf, size_t size) {
+	u8* base = buf;
+	iso_ecs_snapshot_header* header = buf;
+	iso_assert(size >= sizeof(iso_ecs_snapshot_header) && header->magic == ISO_ECS_SNAPSHOT_MAGIC, "Buffer is not an ecs snapshot.\n");
+	iso_assert(header->version == ISO_ECS_SNAPSHOT_VERSION, "Snapshot version `%u` is not supported.\n", header->version);
+	iso_assert(header->size <= size, "Snapshot is truncated.\n");
+	iso_assert(header->free_cnt <= header->entity_cap && header->entity_cnt + header->free_cnt == header->entity_cap, "Snapshot is corrupted.\n");
+	__iso_ecs_snapshot_check(header, sizeof(iso_ecs_snapshot_header), sizeof(iso_ecs_snapshot_record) * (u64) header->record_cnt);
+	__iso_ecs_snapshot_check(header, header->versions, sizeof(u32) * (u64) header->entity_cap);
+	__iso_ecs_snapshot_check(header, header->free_ids, sizeof(u32) * (u64) header->free_cnt);
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+
+	// Emptying the records, they keep their storage for the loaded components
+	iso_comp_table* table = ecs->table;
+	for (u32 i = 0; i < table->record_cnt; i++) {
+		iso_comp_record_clear(table->records[table->record_types[i]]);
+	}
+	table->tick = header->tick;
+
+	// Restoring the entity slots as they were
+	iso_entity_allocator* alloc = &ecs->entities;
+	u32 cap = header->entity_cap ? header->entity_cap : 1;
+	alloc->versions   = iso_realloc(alloc->versions, sizeof(u32) * cap);
+	alloc->free_ids   = iso_realloc(alloc->free_ids, sizeof(u32) * cap);
+	alloc->cap        = header->entity_cap;
+	alloc->entity_cnt = header->entity_cnt;
+	alloc->free_cnt   = header->free_cnt;
+	memcpy(alloc->versions, base + header->versions, sizeof(u32) * header->entity_cap);
+	memcpy(alloc->free_ids, base + header->free_ids, sizeof(u32) * header->free_cnt);
+
+	__iso_ecs_sync_signatures(ecs);
+	memset(ecs->signatures, 0, sizeof(iso_ecs_mask) * ecs->signature_cap);
+
+	iso_ecs_snapshot_record* recs = (iso_ecs_snapshot_record*) (base + sizeof(iso_ecs_snapshot_header));
+	for (u32 i = 0; i < header->record_cnt; i++) {
+		iso_ecs_snapshot_record* desc = &recs[i];
+		b8  tag = desc->size == 0;
+		u64 cnt = tag ? 0 : desc->entry_cnt;
+		u64 chunk_cnt = (cnt + ISO_COMP_RECORD_TICK_CHUNK - 1) >> ISO_COMP_RECORD_TICK_CHUNK_SHIFT;
+
+		iso_assert(memchr(desc->name, '\0', ISO_ECS_TYPE_NAME_SIZE), "Snapshot is corrupted.\n");
+		__iso_ecs_snapshot_check(header, desc->entities, sizeof(iso_entity) * cnt);
+		__iso_ecs_snapshot_check(header, desc->data,     tag ? __iso_ecs_snapshot_tag_size(header) : (u64) desc->size * cnt);
+		__iso_ecs_snapshot_check(header, desc->added,    sizeof(u32) * cnt);
+		__iso_ecs_snapshot_check(header, desc->changed,  sizeof(u32) * cnt);
+		__iso_ecs_snapshot_check(header, desc->chunks,   sizeof(u32) * chunk_cnt);
+
+		// Matching the record by name, type ids depend on the registration order
+		u32 type = __iso_ecs_register_type(desc->name, desc->type_size);
+		iso_comp_record* rec = __iso_ecs_get_or_add_record(ecs, type);
+		if (desc->align && rec->align != desc->align) iso_comp_record_set_align(rec, desc->align);
+		iso_assert(rec->size == desc->size, "Component `%s` of the snapshot has a different layout.\n", rec->name);
+
+		if (tag) {
+			u64* bits = (u64*) (base + desc->data);
+			for (u32 word = 0; word < (alloc->cap + 63) / 64; word++) {
+				for (u64 b = bits[word]; b; b &= b - 1) {
+					u32 id = word * 64 + __builtin_ctzll(b);
+					iso_assert(id < alloc->cap, "Snapshot is corrupted.\n");
+					__iso_comp_record_set_tag(rec, iso_entity_make(id, alloc->versions[id]));
+					iso_ecs_mask_set(&ecs->signatures[id], type);
+				}
+			}
+			rec->version++;
+			continue;
+		}
+
+		iso_comp_record_reserve(rec, desc->entry_cnt);
+		if (cnt) {
+			memcpy(rec->entities, base + desc->entities, sizeof(iso_entity) * cnt);
+			memcpy(rec->data,     base + desc->data,     (size_t) rec->size * cnt);
+			memcpy(rec->added,    base + desc->added,    sizeof(u32) * cnt);
+			memcpy(rec->changed,  base + desc->changed,  sizeof(u32) * cnt);
+			memcpy(rec->chunks,   base + desc->chunks,   sizeof(u32) * chunk_cnt);
+		}
+		rec->entry_cnt = desc->entry_cnt;
+		rec->version++;
+
+		// Rebuilding the sparse index and the signatures
+		for (u32 j = 0; j < desc->entry_cnt; j++) {
+			u32 id = iso_entity_index(rec->entities[j]);
+			iso_assert(id < alloc->cap, "Snapshot is corrupted.\n");
+			*__iso_comp_record_sparse_slot(rec, id) = j;
+			iso_ecs_mask_set(&ecs->signatures[id], type);
+		}
+	}
+
+	iso_memory_pop_tag();
+}
+
+void iso_ecs_snapshot_load(iso_ecs* ecs, char* path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		iso_assert(false, "Failed to open file: %s\n[Reason]: %lu\n", path, GetLastError());
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* map = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	iso_assert(map, "Failed to map file: %s\n[Reason]: %lu\n", path, GetLastError());
+
+	iso_ecs_snapshot_load_buffer(ecs, map, (size_t) size.QuadPart);
+
+	UnmapViewOfFile(map);
+	CloseHandle(mapping);
+	CloseHandle(file);
+#else
+	i32 fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		iso_assert(false, "Failed to open file: %s\n[Reason]: %s\n", path, strerror(errno));
+	}
+
+	struct stat st;
+	fstat(fd, &st);
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	iso_assert(map != MAP_FAILED, "Failed to map file: %s\n[Reason]: %s\n", path, strerror(errno));
+
+	// The arrays are read front to back
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	iso_ecs_snapshot_load_buffer(ecs, map, st.st_size);
+
+	munmap(map, st.st_size);
+#endif
+}
@@ -0,0 +1,136 @@
+#ifndef __ISO_ECS_SNAPSHOT_H__
+#define __ISO_ECS_SNAPSHOT_H__
+
+#include "iso_util/iso_includes.h"
+#include "iso_util/iso_defines.h"
+#include "iso_util/iso_memory.h"
+#include "iso_ecs.h"
+
+/*
+ * Snapshot
+ *
+ * Binary image of the entities and components of an iso_ecs:
+ *
+ *   [header][record 0 .. record n][versions][free ids][entities 0][data 0][ticks 0] ...
+ *
+ * The data of a tag is its bitset (one bit per entity slot), without entities or ticks.
+ *
+ * Every array is the raw packed array of the ecs, starting at an offset aligned to
+ * ISO_ECS_SNAPSHOT_ALIGN, so a mapped file is read straight into the records.
+ * Records are matched by component name, so a snapshot loads into any build that
+ * registers the same components, whatever their type ids are.
+ * Entity handles stay valid across a save and load.
+ * Components are saved and restored bitwise: loading runs the destructors of the
+ * replaced components but no constructor, so components that own memory through
+ * iso_ecs_type_hooks cant be restored from a snapshot.
+ */
+
+// "ISOS" in little endian
+#define ISO_ECS_SNAPSHOT_MAGIC   0x534F5349u
+#define ISO_ECS_SNAPSHOT_VERSION 2
+
+// Alignment of every array of a snapshot
+#define ISO_ECS_SNAPSHOT_ALIGN 64
+
+
+/*
+ * @brief Header at the start of a snapshot (offsets are from the start of the snapshot)
+ * @mem magic      = ISO_ECS_SNAPSHOT_MAGIC
+ * @mem version    = ISO_ECS_SNAPSHOT_VERSION
+ * @mem entity_cap = No of entity slots
+ * @mem entity_cnt = No of live entities
+ * @mem free_cnt   = No of free slot indices
+ * @mem record_cnt = No of iso_ecs_snapshot_record following the header
+ * @mem tick       = Change tick of the component table
+ * @mem size       = Total size of the snapshot in bytes
+ * @mem versions   = Offset of the slot versions (entity_cap u32)
+ * @mem free_ids   = Offset of the free slot stack (free_cnt u32)
+ */
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 entity_cap;
+	u32 entity_cnt;
+	u32 free_cnt;
+	u32 record_cnt;
+	u32 tick;
+	u32 reserved;
+	u64 size;
+	u64 versions;
+	u64 free_ids;
+} iso_ecs_snapshot_header;
+
+
+/*
+ * @brief Schema of a component record in a snapshot
+ * @mem name      = Name of the component
+ * @mem type_size = Size of the component type
+ * @mem size      = Stride of the components in `data` (0 for tags)
+ * @mem align     = Alignment of the component data (0 for the default alignment)
+ * @mem entry_cnt = No of components
+ * @mem entities  = Offset of the entities (entry_cnt iso_entity)
+ * @mem data      = Offset of the component data (entry_cnt * size bytes, the bitset for tags)
+ * @mem added     = Offset of the added ticks (entry_cnt u32)
+ * @mem changed   = Offset of the changed ticks (entry_cnt u32)
+ * @mem chunks    = Offset of the chunk ticks (one u32 per ISO_COMP_RECORD_TICK_CHUNK entries)
+ */
+
+typedef struct {
+	char name[ISO_ECS_TYPE_NAME_SIZE];
+	u32  type_size;
+	u32  size;
+	u32  align;
+	u32  entry_cnt;
+	u64  entities;
+	u64  data;
+	u64  added;
+	u64  changed;
+	u64  chunks;
+} iso_ecs_snapshot_record;
+
+
+/*
+ * @brief Function to get the size of the snapshot of an ecs
+ * @param ecs = Pointer to iso_ecs
+ * @return Returns the size in bytes
+ */
+
+ISO_API size_t iso_ecs_snapshot_size(iso_ecs* ecs);
+
+/*
+ * @brief Function to write the snapshot of an ecs into memory, e.g. to roll back to it later
+ * @param ecs = Pointer to iso_ecs
+ * @param buf = Buffer of at least iso_ecs_snapshot_size bytes (aligned to ISO_ECS_SNAPSHOT_ALIGN)
+ */
+
+ISO_API void iso_ecs_snapshot_write_buffer(iso_ecs* ecs, void* buf);
+
+/*
+ * @brief Function to replace the entities and components of an ecs with a snapshot.
+ *        Systems, the thread pool and the command buffers of the ecs are kept.
+ * @param ecs  = Pointer to iso_ecs
+ * @param buf  = Snapshot
+ * @param size = Size of the buffer
+ */
+
+ISO_API void iso_ecs_snapshot_load_buffer(iso_ecs* ecs, void* buf, size_t size);
+
+/*
+ * @brief Function to write the snapshot of an ecs into a file
+ * @param ecs  = Pointer to iso_ecs
+ * @param path = Path of the file
+ */
+
+ISO_API void iso_ecs_snapshot_write(iso_ecs* ecs, char* path);
+
+/*
+ * @brief Function to load a snapshot file into an ecs. The file is mapped and its
+ *        arrays are copied straight into the records.
+ * @param ecs  = Pointer to iso_ecs
+ * @param path = Path of the file
+ */
+
+ISO_API void iso_ecs_snapshot_load(iso_ecs* ecs, char* path);
+
+#endif // __ISO_ECS_SNAPSHOT_H__
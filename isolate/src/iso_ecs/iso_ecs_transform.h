@@ -0,0 +1,537 @@
+#ifndef __ISO_ECS_TRANSFORM_H__
+#define __ISO_ECS_TRANSFORM_H__
+
+#include "iso_util/iso_includes.h"
+#include "iso_util/iso_defines.h"
+#include "iso_util/iso_memory.h"
+#include "iso_util/iso_thread_pool.h"
+#include "iso_math/iso_math.h"
+#include "iso_ecs.h"
+#include "iso_ecs_query.h"
+
+/*
+ * Transform hierarchy
+ *
+ * Entities with an iso_transform (matrix relative to the parent) are linked into
+ * an iso_transform_tree, which writes their iso_world_transform:
+ *
+ *   iso_transform_tree* tree = iso_transform_tree_new(ecs);
+ *   iso_transform_tree_add(tree, body, ISO_ENTITY_NULL);
+ *   iso_transform_tree_add(tree, arm, body);
+ *
+ *   iso_transform* t = iso_entity_get_component_mut(ecs, arm, iso_transform);
+ *   ...
+ *   iso_transform_tree_propagate(tree);
+ *
+ * Matrices compose like the camera matrices (iso_mat4_translate, mvp = proj * view),
+ * so world = parent world * local.
+ *
+ * The nodes are kept in depth-first order, every subtree is a contiguous range,
+ * so propagation is a single pass that jumps over subtrees without changes.
+ * The rows of the iso_transform and iso_world_transform records are permuted into
+ * the same order, so the pass walks the components linearly and the world of a
+ * parent is an earlier row of the same walk.
+ * Reparenting only relinks the node, the order is rebuilt once before the next
+ * propagation (and the records permuted again after components were added or
+ * removed). Subtrees of different roots are propagated in parallel on the
+ * thread pool of the ecs.
+ */
+
+/*
+ * @brief Transform of an entity relative to its parent (or to the world for roots)
+ * @mem local = Local matrix
+ */
+
+typedef struct {
+	iso_mat4 local;
+} iso_transform;
+
+/*
+ * @brief Transform of an entity relative to the world, written by iso_transform_tree_propagate
+ * @mem world = World matrix
+ */
+
+typedef struct {
+	iso_mat4 world;
+} iso_world_transform;
+
+
+// Marks a missing node link
+#define ISO_TRANSFORM_NONE ((u32) -1)
+
+
+/*
+ * @brief Links of an entity in the hierarchy (indexed by entity index)
+ * @mem ent          = Entity of the node
+ * @mem parent       = Entity index of the parent (ISO_TRANSFORM_NONE for roots)
+ * @mem first_child  = Entity index of the first child
+ * @mem next_sibling = Entity index of the next sibling (roots are siblings of each other)
+ * @mem prev_sibling = Entity index of the previous sibling
+ * @mem pos          = Position of the node in the depth-first order
+ * @mem linked       = Whether the entity is part of the hierarchy
+ * @mem queued       = Whether the node is in the queue of nodes to recompute
+ */
+
+typedef struct {
+	iso_entity ent;
+	u32 parent;
+	u32 first_child;
+	u32 next_sibling;
+	u32 prev_sibling;
+	u32 pos;
+	b8  linked;
+	b8  queued;
+} iso_transform_node;
+
+
+// Flags of a position of the depth-first order
+#define ISO_TRANSFORM_DIRTY       1  // Node changed, its subtree has to be recomputed
+#define ISO_TRANSFORM_CHILD_DIRTY 2  // Some node below is dirty
+
+/*
+ * @brief Hierarchy of the transforms of an ecs
+ * @mem ecs           = Pointer to the iso_ecs
+ * @mem nodes         = Links of every entity slot
+ * @mem node_cap      = No of entries in `nodes`
+ * @mem first_root    = Entity index of the first root
+ * @mem node_cnt      = No of entities in the hierarchy
+ * @mem queue         = Entity indices of the nodes to recompute, resolved to positions before a propagation
+ * @mem queue_cnt     = No of entries in `queue`
+ * @mem queue_cap     = Capacity of `queue`
+ * @mem order         = Entity indices in depth-first order (also the rows of both records)
+ * @mem order_end     = End of the subtree of every position of `order` (exclusive)
+ * @mem order_parent  = Position of the parent of every position (ISO_TRANSFORM_NONE for roots)
+ * @mem flags         = ISO_TRANSFORM_DIRTY and ISO_TRANSFORM_CHILD_DIRTY of every position
+ * @mem root_starts   = Start of the subtree of every root in `order` (root_cnt + 1 entries)
+ * @mem root_cnt      = No of roots
+ * @mem order_cap     = Capacity of the arrays of the order
+ * @mem order_dirty   = Set when the links changed and the order has to be rebuilt
+ * @mem versions      = Versions of the iso_transform and iso_world_transform records once permuted
+ * @mem changed       = Query of the transforms written since the last propagation
+ */
+
+typedef struct {
+	iso_ecs* ecs;
+	iso_transform_node* nodes;
+	u32 node_cap;
+	u32 first_root;
+	u32 node_cnt;
+
+	u32* queue;
+	u32  queue_cnt;
+	u32  queue_cap;
+
+	u32* order;
+	u32* order_end;
+	u32* order_parent;
+	u8*  flags;
+	u32* root_starts;
+	u32  root_cnt;
+	u32  order_cap;
+	b8   order_dirty;
+	u32  versions[2];
+
+	iso_ecs_query changed;
+} iso_transform_tree;
+
+
+/*
+ * @brief Function to create a transform hierarchy
+ * @param ecs = Pointer to the iso_ecs
+ * @return Returns pointer to the iso_transform_tree
+ */
+
+static iso_transform_tree* iso_transform_tree_new(iso_ecs* ecs) {
+	iso_transform_tree* tree = iso_alloc(sizeof(iso_transform_tree));
+	tree->ecs = ecs;
+	tree->first_root = ISO_TRANSFORM_NONE;
+	tree->changed = iso_ecs_query_new(ecs);
+	iso_ecs_query_changed(&tree->changed, iso_transform);
+	return tree;
+}
+
+
+/*
+ * @brief Function to delete the transform hierarchy (the components are kept)
+ * @param tree = Pointer to the iso_transform_tree
+ */
+
+static void iso_transform_tree_delete(iso_transform_tree* tree) {
+	iso_ecs_query_delete(&tree->changed);
+	iso_free(tree->nodes);
+	iso_free(tree->queue);
+	iso_free(tree->order);
+	iso_free(tree->order_end);
+	iso_free(tree->order_parent);
+	iso_free(tree->flags);
+	iso_free(tree->root_starts);
+	iso_free(tree);
+}
+
+
+/*
+ * @brief Internal function to grow the nodes along with the entity slots
+ * @param tree = Pointer to the iso_transform_tree
+ */
+
+static void __iso_transform_tree_sync(iso_transform_tree* tree) {
+	u32 cap = tree->ecs->entities.cap;
+	if (tree->node_cap >= cap) return;
+
+	iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+	tree->nodes = iso_realloc(tree->nodes, sizeof(iso_transform_node) * cap);
+	memset(tree->nodes + tree->node_cap, 0, sizeof(iso_transform_node) * (cap - tree->node_cap));
+	tree->node_cap = cap;
+	iso_memory_pop_tag();
+}
+
+
+/*
+ * @brief Internal function to get the node of a linked entity
+ */
+
+static iso_transform_node* __iso_transform_tree_node(iso_transform_tree* tree, iso_entity ent) {
+	u32 id = iso_entity_index(ent);
+	iso_assert(iso_entity_alive(tree->ecs, ent), "Entity `%u` doesnt exists.\n", id);
+	iso_assert(id < tree->node_cap && tree->nodes[id].linked, "Entity `%u` is not part of the transform hierarchy.\n", id);
+	return &tree->nodes[id];
+}
+
+
+/*
+ * @brief Internal function to queue a node to be recomputed by the next propagation
+ * @param tree = Pointer to the iso_transform_tree
+ * @param id   = Entity index of the node
+ */
+
+static void __iso_transform_tree_queue(iso_transform_tree* tree, u32 id) {
+	if (tree->nodes[id].queued) return;
+	tree->nodes[id].queued = true;
+
+	if (tree->queue_cnt == tree->queue_cap) {
+		tree->queue_cap = tree->queue_cap ? tree->queue_cap * 2 : 64;
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		tree->queue = iso_realloc(tree->queue, sizeof(u32) * tree->queue_cap);
+		iso_memory_pop_tag();
+	}
+	tree->queue[tree->queue_cnt++] = id;
+}
+
+
+/*
+ * @brief Internal function to unlink a node from its parent (or from the roots)
+ */
+
+static void __iso_transform_tree_unlink(iso_transform_tree* tree, u32 id) {
+	iso_transform_node* node = &tree->nodes[id];
+
+	if (node->prev_sibling != ISO_TRANSFORM_NONE) {
+		tree->nodes[node->prev_sibling].next_sibling = node->next_sibling;
+	} else if (node->parent != ISO_TRANSFORM_NONE) {
+		tree->nodes[node->parent].first_child = node->next_sibling;
+	} else {
+		tree->first_root = node->next_sibling;
+	}
+	if (node->next_sibling != ISO_TRANSFORM_NONE) {
+		tree->nodes[node->next_sibling].prev_sibling = node->prev_sibling;
+	}
+
+	node->parent = node->next_sibling = node->prev_sibling = ISO_TRANSFORM_NONE;
+}
+
+
+/*
+ * @brief Internal function to link a node as the first child of a parent (or as a root)
+ */
+
+static void __iso_transform_tree_link(iso_transform_tree* tree, u32 id, u32 parent) {
+	iso_transform_node* node = &tree->nodes[id];
+	u32* head = parent == ISO_TRANSFORM_NONE ? &tree->first_root : &tree->nodes[parent].first_child;
+
+	node->parent = parent;
+	node->prev_sibling = ISO_TRANSFORM_NONE;
+	node->next_sibling = *head;
+	if (*head != ISO_TRANSFORM_NONE) tree->nodes[*head].prev_sibling = id;
+	*head = id;
+
+	tree->order_dirty = true;
+	__iso_transform_tree_queue(tree, id);
+}
+
+
+/*
+ * @brief Function to add an entity to the hierarchy. The entity needs an iso_transform,
+ *        an iso_world_transform is added to it if missing.
+ * @param tree   = Pointer to the iso_transform_tree
+ * @param ent    = Entity to add
+ * @param parent = Parent entity (ISO_ENTITY_NULL to add a root)
+ */
+
+static void iso_transform_tree_add(iso_transform_tree* tree, iso_entity ent, iso_entity parent) {
+	iso_ecs* ecs = tree->ecs;
+	iso_assert(iso_entity_has_component(ecs, ent, iso_transform), "Entity `%u` doesnt have an iso_transform.\n", iso_entity_index(ent));
+	if (!iso_entity_has_component(ecs, ent, iso_world_transform)) {
+		iso_entity_add_component(ecs, ent, iso_world_transform, iso_mat4_identity());
+	}
+
+	__iso_transform_tree_sync(tree);
+	u32 id = iso_entity_index(ent);
+	iso_assert(!tree->nodes[id].linked, "Entity `%u` is already part of the transform hierarchy.\n", id);
+
+	u32 parent_id = ISO_TRANSFORM_NONE;
+	if (parent != ISO_ENTITY_NULL) {
+		__iso_transform_tree_node(tree, parent);
+		parent_id = iso_entity_index(parent);
+	}
+
+	tree->nodes[id] = (iso_transform_node) {
+		.ent          = ent,
+		.parent       = ISO_TRANSFORM_NONE,
+		.first_child  = ISO_TRANSFORM_NONE,
+		.next_sibling = ISO_TRANSFORM_NONE,
+		.prev_sibling = ISO_TRANSFORM_NONE,
+		.linked       = true
+	};
+	__iso_transform_tree_link(tree, id, parent_id);
+	tree->node_cnt++;
+}
+
+
+/*
+ * @brief Function to move an entity (with its subtree) under another parent
+ * @param tree   = Pointer to the iso_transform_tree
+ * @param ent    = Entity to move
+ * @param parent = New parent (ISO_ENTITY_NULL to make the entity a root)
+ */
+
+static void iso_transform_tree_set_parent(iso_transform_tree* tree, iso_entity ent, iso_entity parent) {
+	__iso_transform_tree_node(tree, ent);
+	u32 id = iso_entity_index(ent);
+
+	u32 parent_id = ISO_TRANSFORM_NONE;
+	if (parent != ISO_ENTITY_NULL) {
+		__iso_transform_tree_node(tree, parent);
+		parent_id = iso_entity_index(parent);
+
+		for (u32 p = parent_id; p != ISO_TRANSFORM_NONE; p = tree->nodes[p].parent) {
+			iso_assert(p != id, "Entity `%u` cant be parented to its own subtree.\n", id);
+		}
+	}
+
+	__iso_transform_tree_unlink(tree, id);
+	__iso_transform_tree_link(tree, id, parent_id);
+}
+
+
+/*
+ * @brief Function to remove an entity from the hierarchy, its children become roots.
+ *        Entities have to be removed before they are deleted from the ecs.
+ * @param tree = Pointer to the iso_transform_tree
+ * @param ent  = Entity to remove
+ */
+
+static void iso_transform_tree_remove(iso_transform_tree* tree, iso_entity ent) {
+	iso_transform_node* node = __iso_transform_tree_node(tree, ent);
+	u32 id = iso_entity_index(ent);
+
+	while (node->first_child != ISO_TRANSFORM_NONE) {
+		u32 child = node->first_child;
+		__iso_transform_tree_unlink(tree, child);
+		__iso_transform_tree_link(tree, child, ISO_TRANSFORM_NONE);
+	}
+
+	__iso_transform_tree_unlink(tree, id);
+	node->linked = false;
+	tree->order_dirty = true;
+	tree->node_cnt--;
+}
+
+
+/*
+ * @brief Function to get the parent of an entity
+ * @param tree = Pointer to the iso_transform_tree
+ * @param ent  = Entity
+ * @return Returns the parent or ISO_ENTITY_NULL for roots
+ */
+
+static iso_entity iso_transform_tree_parent(iso_transform_tree* tree, iso_entity ent) {
+	u32 parent = __iso_transform_tree_node(tree, ent)->parent;
+	return parent == ISO_TRANSFORM_NONE ? ISO_ENTITY_NULL : tree->nodes[parent].ent;
+}
+
+
+/*
+ * @brief Internal function to lay the nodes out in depth-first order, one range per root
+ * @param tree = Pointer to the iso_transform_tree
+ */
+
+static void __iso_transform_tree_build_order(iso_transform_tree* tree) {
+	if (tree->order_cap < tree->node_cnt + 1) {
+		tree->order_cap = tree->node_cnt + 1;
+		iso_memory_push_tag(ISO_MEMORY_TAG_ECS);
+		tree->order        = iso_realloc(tree->order, sizeof(u32) * tree->order_cap);
+		tree->order_end    = iso_realloc(tree->order_end, sizeof(u32) * tree->order_cap);
+		tree->order_parent = iso_realloc(tree->order_parent, sizeof(u32) * tree->order_cap);
+		tree->flags        = iso_realloc(tree->flags, tree->order_cap);
+		tree->root_starts  = iso_realloc(tree->root_starts, sizeof(u32) * tree->order_cap);
+		iso_memory_pop_tag();
+	}
+
+	iso_transform_node* nodes = tree->nodes;
+	u32 n = 0;
+	tree->root_cnt = 0;
+
+	for (u32 root = tree->first_root; root != ISO_TRANSFORM_NONE; root = nodes[root].next_sibling) {
+		tree->root_starts[tree->root_cnt++] = n;
+
+		// Walking the subtree through the links, without a stack
+		u32 cur = root;
+		for (;;) {
+			nodes[cur].pos = n;
+			tree->order_parent[n] = cur == root ? ISO_TRANSFORM_NONE : nodes[nodes[cur].parent].pos;
+			tree->flags[n] = 0;
+			tree->order[n++] = cur;
+			if (nodes[cur].first_child != ISO_TRANSFORM_NONE) {
+				cur = nodes[cur].first_child;
+				continue;
+			}
+
+			// Closing the subtrees that end at this leaf
+			while (cur != root && nodes[cur].next_sibling == ISO_TRANSFORM_NONE) {
+				tree->order_end[nodes[cur].pos] = n;
+				cur = nodes[cur].parent;
+			}
+			tree->order_end[nodes[cur].pos] = n;
+			if (cur == root) break;
+			cur = nodes[cur].next_sibling;
+		}
+	}
+
+	tree->root_starts[tree->root_cnt] = n;
+	tree->order_dirty = false;
+}
+
+
+/*
+ * @brief Internal function to permute the rows of both records into the depth-first order
+ * @param tree   = Pointer to the iso_transform_tree
+ * @param locals = Record of iso_transform
+ * @param worlds = Record of iso_world_transform
+ */
+
+static void __iso_transform_tree_permute(iso_transform_tree* tree, iso_comp_record* locals, iso_comp_record* worlds) {
+	iso_comp_record_reorder(locals, tree->order, tree->node_cnt);
+	iso_comp_record_reorder(worlds, tree->order, tree->node_cnt);
+	tree->versions[0] = locals->version;
+	tree->versions[1] = worlds->version;
+}
+
+
+/*
+ * @brief Internal function to flag the queued nodes dirty and their ancestors as having a dirty child
+ * @param tree = Pointer to the iso_transform_tree
+ */
+
+static void __iso_transform_tree_flag_queue(iso_transform_tree* tree) {
+	for (u32 i = 0; i < tree->queue_cnt; i++) {
+		iso_transform_node* node = &tree->nodes[tree->queue[i]];
+		node->queued = false;
+		if (!node->linked) continue;
+
+		tree->flags[node->pos] |= ISO_TRANSFORM_DIRTY;
+
+		// Ancestors that are flagged already have their whole chain flagged
+		for (u32 p = tree->order_parent[node->pos]; p != ISO_TRANSFORM_NONE && !(tree->flags[p] & ISO_TRANSFORM_CHILD_DIRTY); p = tree->order_parent[p]) {
+			tree->flags[p] |= ISO_TRANSFORM_CHILD_DIRTY;
+		}
+	}
+	tree->queue_cnt = 0;
+}
+
+
+/*
+ * @brief Internal job propagating the subtrees of a range of roots
+ * @param data  = Pointer to the iso_transform_tree
+ * @param start = First root
+ * @param end   = End of the roots (exclusive)
+ */
+
+static void __iso_transform_tree_job(void* data, u32 start, u32 end) {
+	iso_transform_tree* tree = data;
+	iso_comp_record* locals = iso_ecs_get_record(tree->ecs, iso_transform);
+	iso_comp_record* worlds = iso_ecs_get_record(tree->ecs, iso_world_transform);
+
+	// Row `i` of both records is the node at position `i`
+	for (u32 r = start; r < end; r++) {
+		u32 i    = tree->root_starts[r];
+		u32 last = tree->root_starts[r + 1];
+
+		// Nodes before `force_end` are below a dirty node and are always recomputed
+		u32 force_end = i;
+		while (i < last) {
+			u8 flags = tree->flags[i];
+
+			if (i >= force_end && flags == 0) {
+				i = tree->order_end[i];
+				continue;
+			}
+			if (flags & ISO_TRANSFORM_DIRTY && tree->order_end[i] > force_end) force_end = tree->order_end[i];
+
+			if (i < force_end) {
+				iso_mat4* local = (iso_mat4*) (locals->data + (size_t) i * locals->size);
+				iso_mat4* world = (iso_mat4*) (worlds->data + (size_t) i * worlds->size);
+
+				u32 parent = tree->order_parent[i];
+				if (parent == ISO_TRANSFORM_NONE) {
+					*world = *local;
+				} else {
+					*world = iso_mat4_mul(*(iso_mat4*) (worlds->data + (size_t) parent * worlds->size), *local);
+				}
+				iso_comp_record_mark_changed(worlds, i);
+			}
+
+			tree->flags[i] = 0;
+			i++;
+		}
+	}
+}
+
+
+/*
+ * @brief Function to recompute the world transforms of the nodes whose transform,
+ *        or the transform of an ancestor, was written (iso_entity_get_component_mut or
+ *        iso_ecs_query_get_mut) or whose parent changed since the last propagation
+ * @param tree = Pointer to the iso_transform_tree
+ */
+
+static void iso_transform_tree_propagate(iso_transform_tree* tree) {
+	while (iso_ecs_query_next(&tree->changed)) {
+		u32 id = iso_entity_index(tree->changed.entity);
+		if (id < tree->node_cap && tree->nodes[id].linked) __iso_transform_tree_queue(tree, id);
+	}
+
+	if (tree->node_cnt == 0) {
+		for (u32 i = 0; i < tree->queue_cnt; i++) tree->nodes[tree->queue[i]].queued = false;
+		tree->queue_cnt = 0;
+		return;
+	}
+
+	// Adds and removes of either component move rows, the records are permuted again
+	iso_comp_record* locals = iso_ecs_get_record(tree->ecs, iso_transform);
+	iso_comp_record* worlds = iso_ecs_get_record(tree->ecs, iso_world_transform);
+	if (tree->order_dirty) {
+		__iso_transform_tree_build_order(tree);
+		__iso_transform_tree_permute(tree, locals, worlds);
+	} else if (tree->versions[0] != locals->version || tree->versions[1] != worlds->version) {
+		__iso_transform_tree_permute(tree, locals, worlds);
+	}
+	__iso_transform_tree_flag_queue(tree);
+
+	// A few batches of roots per thread to even out subtrees of different sizes
+	iso_thread_pool* pool = tree->ecs->pool;
+	u32 share = pool ? (pool->thread_cnt + 1) * 4 : 1;
+	u32 batch = (tree->root_cnt + share - 1) / share;
+	iso_thread_pool_parallel_for(pool, tree->root_cnt, batch, __iso_transform_tree_job, tree);
+}
+
+#endif // __ISO_ECS_TRANSFORM_H__
@@ -11,6 +11,9 @@ i32 iso_run(i32 argc, char** argv, iso_entry_def def) {
 	// Init
 	iso_app_def app_def = def.iso_init();
 
+	// Profiling allocations from the app construction onwards
+	if (app_def.profile_allocs) iso_memory_profiler_start();
+
 	// Creating the app
 	app = iso_app_new(app_def);
 
@@ -51,6 +54,10 @@ i32 iso_run(i32 argc, char** argv, iso_entry_def def) {
 		scene->on_update(scene, dt);
 		frame_cnt++;
 
+		// Releasing the transient allocations of the frame before the previous one
+		iso_app_next_frame(app);
+		iso_memory_profiler_next_frame();
+
 		// Capping the frames
 		dt = SDL_GetTicks() - start_tick;
 		if (unit_frame > dt) {
@@ -81,6 +88,12 @@ i32 iso_run(i32 argc, char** argv, iso_entry_def def) {
 	// Cleaning app
 	iso_app_delete(app);
 
+	// Reporting the allocation profile
+	if (app_def.profile_allocs) {
+		iso_memory_profiler_report(ISO_MEMORY_PROFILE_TOP_N);
+		if (app_def.alloc_profile_csv) iso_memory_profiler_dump_csv(app_def.alloc_profile_csv);
+	}
+
 	// Alerting incase of memory leaks
 	iso_memory_alert();
 
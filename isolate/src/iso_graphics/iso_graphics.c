@@ -47,6 +47,7 @@ void __iso_load_opengl_functions(iso_graphics* graphics) {
 }
 
 iso_graphics* iso_graphics_new(iso_graphics_def graphics_def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_graphics* graphics = iso_alloc(sizeof(iso_graphics));
 
 	iso_log_info("Constructing iso_graphics api: `%s` ...\n", iso_graphics_api_to_str(graphics_def.api));
@@ -62,6 +63,7 @@ iso_graphics* iso_graphics_new(iso_graphics_def graphics_def) {
 
 	iso_log_sucess("Created iso_graphics:\n\tAPI: `%s`\n", iso_graphics_api_to_str(graphics_def.api));
 
+	iso_memory_pop_tag();
 	return graphics;
 }
 
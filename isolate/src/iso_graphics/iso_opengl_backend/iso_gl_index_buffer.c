@@ -2,6 +2,7 @@
 #include "iso_gl_util.h"
 
 iso_index_buffer* iso_gl_index_buffer_new(iso_graphics* graphics, iso_index_buffer_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Constructing iso_gl_index_buffer...\n");
 
 	iso_index_buffer* ibo = iso_alloc(sizeof(iso_index_buffer));
@@ -31,6 +32,7 @@ iso_index_buffer* iso_gl_index_buffer_new(iso_graphics* graphics, iso_index_buff
 
 	iso_log_sucess("Created opengl_index_buffer: (Name:`%s` ID:%d)\n", ibo->name, ibo->id);
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return ibo;
 }
 
@@ -42,6 +42,7 @@ iso_str iso_render_type_to_str(iso_render_type type) {
 }
 
 iso_render_pipeline* iso_gl_render_pipeline_new(iso_graphics* graphics, iso_render_pipeline_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Constructing render pipeline...\n");
 
 	iso_render_pipeline* pip = iso_alloc(sizeof(iso_render_pipeline));
@@ -120,6 +121,7 @@ iso_render_pipeline* iso_gl_render_pipeline_new(iso_graphics* graphics, iso_rend
 	);
 
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return pip;
 }
 
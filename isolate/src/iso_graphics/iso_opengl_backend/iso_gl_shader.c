@@ -3,6 +3,7 @@
 #include "iso_util/iso_file.h"
 
 iso_shader* iso_gl_shader_new(iso_graphics* graphics, iso_shader_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Constructing opengl_shader...\n");
 
 	iso_shader* shader = iso_alloc(sizeof(iso_shader));
@@ -33,6 +34,7 @@ iso_shader* iso_gl_shader_new(iso_graphics* graphics, iso_shader_def def) {
 
 	iso_log_sucess("Created shader: (Name: `%s` ID: %d)\n", shader->name, shader->id);
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return shader;
 }
 
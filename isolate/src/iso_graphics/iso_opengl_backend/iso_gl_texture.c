@@ -2,6 +2,7 @@
 #include "iso_gl_util.h"
 
 iso_texture* iso_gl_texture_new_from_file(iso_graphics* graphics, iso_texture_from_file_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Loading texture from file: `%s`...\n", def.file_path);
 
 	iso_texture* texture = iso_alloc(sizeof(iso_texture));
@@ -43,10 +44,12 @@ iso_texture* iso_gl_texture_new_from_file(iso_graphics* graphics, iso_texture_fr
 	iso_log_sucess("Created opengl_texture: (Name: `%s` ID: %d Res: %dx%d)\n", texture->name, texture->id, texture->width, texture->height);
 
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return texture;
 }
 
 iso_texture* iso_gl_texture_new_from_data(iso_graphics* graphics, iso_texture_from_data_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Loading texture from data...\n");
 
 	iso_texture* texture = iso_alloc(sizeof(iso_texture));
@@ -80,6 +83,7 @@ iso_texture* iso_gl_texture_new_from_data(iso_graphics* graphics, iso_texture_fr
 	iso_log_sucess("Created opengl_texture: (Name: `%s` ID: %d Res: %dx%d)\n", texture->name, texture->id, texture->width, texture->height);
 
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return texture;
 }
 
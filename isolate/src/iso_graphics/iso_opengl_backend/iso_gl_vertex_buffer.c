@@ -2,6 +2,7 @@
 #include "iso_gl_util.h"
 
 iso_vertex_buffer* iso_gl_vertex_buffer_new(iso_graphics* graphics, iso_vertex_buffer_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_GRAPHICS);
 	iso_log_info("Constructing iso_gl_vertex_buffer...\n");
 
 	iso_vertex_buffer* vbo = iso_alloc(sizeof(iso_vertex_buffer));
@@ -31,6 +32,7 @@ iso_vertex_buffer* iso_gl_vertex_buffer_new(iso_graphics* graphics, iso_vertex_b
 
 	iso_log_sucess("Created iso_gl_vertex_buffer: (Name:`%s` ID:%d)\n", vbo->name, vbo->id);
 	iso_str_delete(tmp);
+	iso_memory_pop_tag();
 	return vbo;
 }
 
@@ -1,13 +1,19 @@
 #include "iso_scene.h"
 
 iso_scene_manager* iso_scene_manager_new() {
+	iso_memory_push_tag(ISO_MEMORY_TAG_SCENE);
 	iso_log_info("Constructing scene manager...\n");
 
 	iso_scene_manager* manager = iso_alloc(sizeof(iso_scene_manager));
 	manager->current_scene = iso_str_new("");
 	manager->scenes = NULL;
+	manager->scene_pool = iso_pool_new((iso_pool_def) {
+		.name     = "iso_scene",
+		.obj_size = sizeof(iso_scene)
+	});
 
 	iso_log_sucess("Created scene manager.\n");
+	iso_memory_pop_tag();
 	return manager;
 }
 
@@ -16,6 +22,7 @@ void iso_scene_manager_delete(iso_scene_manager* manager) {
 
 	iso_hmap_delete(manager->scenes);
 	iso_str_delete(manager->current_scene);
+	iso_pool_delete(manager->scene_pool);
 	iso_free(manager);
 
 	iso_log_sucess("Deleted scene manager.\n");
@@ -30,13 +37,14 @@ void iso_scene_manager_reset(iso_scene_manager* manager) {
 }
 
 void iso_scene_new(iso_scene_manager* manager, iso_scene_def def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_SCENE);
 	iso_str tmp_name = iso_str_new(def.name);
 
 	iso_assert(iso_str_len(tmp_name) > 0, "Name of the scene isnt provided.\n");
 
 	iso_log_info("Constructing scene: `%s` ...\n", tmp_name);
 
-	iso_scene* scene = iso_alloc(sizeof(iso_scene));
+	iso_scene* scene = iso_pool_alloc(manager->scene_pool);
 
 	scene->name = iso_str_new(tmp_name);
 	iso_str_delete(tmp_name);
@@ -50,10 +58,13 @@ void iso_scene_new(iso_scene_manager* manager, iso_scene_def def) {
 	scene->on_update  = def.on_update;
 	scene->on_event   = def.on_event;
 
-	// Calling the constructor
+	// Calling the constructor, its allocations belong to the user
+	iso_memory_pop_tag();
 	scene->new(scene);
 
+	iso_memory_push_tag(ISO_MEMORY_TAG_SCENE);
 	iso_hmap_add(manager->scenes, scene->name, scene);
+	iso_memory_pop_tag();
 
 	if (iso_str_len(manager->current_scene) == 0) {
 		iso_scene_switch(manager, scene->name);
@@ -90,7 +101,7 @@ void iso_scene_delete(iso_scene_manager* manager, iso_str name) {
 
 	iso_str_delete(scene->name);
 	iso_str_delete(tmp_name);
-	iso_free(scene);
+	iso_pool_free(manager->scene_pool, scene);
 
 }
 
@@ -111,7 +122,9 @@ void iso_scene_switch(iso_scene_manager* manager, iso_str name) {
 	}
 
 	iso_str_delete(manager->current_scene);
+	iso_memory_push_tag(ISO_MEMORY_TAG_SCENE);
 	manager->current_scene = iso_str_new(tmp_name);
+	iso_memory_pop_tag();
 	iso_str_delete(tmp_name);
 
 	iso_scene* scene;
@@ -5,6 +5,7 @@
 #include "iso_util/iso_hash_map.h"
 #include "iso_util/iso_log.h"
 #include "iso_util/iso_str.h"
+#include "iso_util/iso_pool.h"
 
 
 /*
@@ -48,12 +49,14 @@ typedef struct {
  * @brief Scene manager struct
  * @mem scenes        = Hash map to hold all scenes
  * @mem current_scene = Name of the currently active scene
+ * @mem scene_pool    = Pool that the scenes are allocated from
  */
 
 #define ISO_SCENE_MANAGER_MEM_SZ 100
 typedef struct {
 	iso_hmap(iso_str, iso_scene*, ISO_SCENE_MANAGER_MEM_SZ) scenes;
 	iso_str current_scene;
+	iso_pool* scene_pool;
 } iso_scene_manager;
 
 
@@ -0,0 +1,85 @@
+#include "iso_arena.h"
+
+static iso_arena_chunk* __iso_arena_chunk_new(iso_arena* arena, size_t cap) {
+	iso_memory_push_tag(arena->tag);
+	iso_arena_chunk* chunk = iso_alloc_uninit(sizeof(iso_arena_chunk) + cap);
+	iso_memory_pop_tag();
+	chunk->next = NULL;
+	chunk->cap  = cap;
+	chunk->used = 0;
+	return chunk;
+}
+
+iso_arena* iso_arena_new(size_t chunk_size) {
+	iso_arena* arena = iso_alloc(sizeof(iso_arena));
+	arena->chunk_size = chunk_size;
+	arena->tag        = iso_memory_get_tag();
+	arena->first      = __iso_arena_chunk_new(arena, chunk_size);
+	arena->current    = arena->first;
+	arena->used       = 0;
+	arena->peak       = 0;
+	return arena;
+}
+
+void iso_arena_delete(iso_arena* arena) {
+	iso_arena_chunk* chunk = arena->first;
+	while (chunk != NULL) {
+		iso_arena_chunk* next = chunk->next;
+		iso_free(chunk);
+		chunk = next;
+	}
+	iso_free(arena);
+}
+
+void* iso_arena_alloc_aligned(iso_arena* arena, size_t size, size_t align) {
+	iso_assert(align && (align & (align - 1)) == 0, "Arena alignment `%zu` is not a power of two.\n", align);
+
+	iso_arena_chunk* chunk = arena->current;
+	for (;;) {
+		uintptr_t base = (uintptr_t) chunk->data;
+		uintptr_t addr = (base + chunk->used + (align - 1)) & ~((uintptr_t) align - 1);
+		size_t end = (addr - base) + size;
+
+		if (end <= chunk->cap) {
+			arena->used += end - chunk->used;
+			if (arena->used > arena->peak) arena->peak = arena->used;
+
+			chunk->used = end;
+			arena->current = chunk;
+			return (void*) addr;
+		}
+
+		// Moving to the next chunk, reusing the ones kept from previous resets
+		if (chunk->next == NULL || chunk->next->cap < size + align) {
+			size_t cap = arena->chunk_size;
+			if (cap < size + align) cap = size + align;
+
+			iso_arena_chunk* new_chunk = __iso_arena_chunk_new(arena, cap);
+			new_chunk->next = chunk->next;
+			chunk->next = new_chunk;
+		}
+
+		chunk = chunk->next;
+		chunk->used = 0;
+	}
+}
+
+iso_arena_mark iso_arena_get_mark(iso_arena* arena) {
+	return (iso_arena_mark) {
+		.chunk = arena->current,
+		.used  = arena->current->used,
+		.total = arena->used
+	};
+}
+
+void iso_arena_rewind(iso_arena* arena, iso_arena_mark mark) {
+	arena->current = mark.chunk;
+	arena->current->used = mark.used;
+	arena->used = mark.total;
+}
+
+void iso_arena_reset(iso_arena* arena) {
+	arena->current = arena->first;
+	arena->current->used = 0;
+	arena->used = 0;
+}
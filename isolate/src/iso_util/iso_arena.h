@@ -0,0 +1,132 @@
+#ifndef __ISO_ARENA_H__
+#define __ISO_ARENA_H__
+
+#include "iso_includes.h"
+#include "iso_defines.h"
+#include "iso_memory.h"
+
+// Default alignment of arena allocations
+#define ISO_ARENA_ALIGN 16
+
+/*
+ * @brief Single chunk of memory owned by the arena
+ * @mem next = Next chunk in the arena
+ * @mem cap  = Capacity of the chunk in bytes
+ * @mem used = Bytes already handed out from the chunk
+ * @mem data = Memory of the chunk
+ */
+
+typedef struct iso_arena_chunk iso_arena_chunk;
+struct iso_arena_chunk {
+	iso_arena_chunk* next;
+	size_t cap;
+	size_t used;
+	_Alignas(ISO_ARENA_ALIGN) u8 data[];
+};
+
+/*
+ * @brief Linear (bump) allocator. Individual allocations are never freed,
+ *        the whole arena is reset or rewound to a mark instead.
+ * @mem first      = First chunk of the arena
+ * @mem current    = Chunk that allocations are currently served from
+ * @mem chunk_size = Default size of newly created chunks
+ * @mem used       = Bytes allocated since the last reset
+ * @mem peak       = Highest `used` seen so far
+ * @mem tag        = iso_memory_tag the chunks are charged to (the tag active at creation)
+ */
+
+typedef struct {
+	iso_arena_chunk* first;
+	iso_arena_chunk* current;
+	size_t chunk_size;
+	size_t used;
+	size_t peak;
+	u32    tag;
+} iso_arena;
+
+/*
+ * @brief Saved position of the arena that can be rewound to
+ * @mem chunk = Chunk that was current when the mark was taken
+ * @mem used  = Used bytes of the chunk when the mark was taken
+ * @mem total = Total used bytes of the arena when the mark was taken
+ */
+
+typedef struct {
+	iso_arena_chunk* chunk;
+	size_t used;
+	size_t total;
+} iso_arena_mark;
+
+
+/*
+ * @brief Function to create a new arena
+ * @param chunk_size = Size of each chunk of the arena in bytes
+ * @return Returns pointer to the iso_arena
+ */
+
+ISO_API iso_arena* iso_arena_new(size_t chunk_size);
+
+/*
+ * @brief Function to delete the arena and all of its chunks
+ * @param arena = Pointer to the iso_arena
+ */
+
+ISO_API void iso_arena_delete(iso_arena* arena);
+
+/*
+ * @brief Function to allocate memory from the arena. Memory is not zeroed.
+ * @param arena = Pointer to the iso_arena
+ * @param size  = Size in bytes
+ * @return Returns pointer to the allocated memory
+ */
+
+#define iso_arena_alloc(arena, size) iso_arena_alloc_aligned(arena, size, ISO_ARENA_ALIGN)
+
+/*
+ * @brief Function to allocate aligned memory from the arena. Memory is not zeroed.
+ * @param arena = Pointer to the iso_arena
+ * @param size  = Size in bytes
+ * @param align = Alignment in bytes (power of two)
+ * @return Returns pointer to the allocated memory
+ */
+
+ISO_API void* iso_arena_alloc_aligned(iso_arena* arena, size_t size, size_t align);
+
+/*
+ * @brief Macro to allocate a zeroed array of `cnt` elements of type `T`
+ * @param arena = Pointer to the iso_arena
+ * @param T     = Type of the element
+ * @param cnt   = Number of elements
+ */
+
+#define iso_arena_push_array(arena, T, cnt)                               \
+	({                                                                      \
+		T* __arr = iso_arena_alloc_aligned(arena, sizeof(T) * (cnt), _Alignof(T)); \
+		memset(__arr, 0, sizeof(T) * (cnt));                                  \
+		__arr;                                                                \
+	})
+
+/*
+ * @brief Function to get the current position of the arena
+ * @param arena = Pointer to the iso_arena
+ * @return Returns the iso_arena_mark
+ */
+
+ISO_API iso_arena_mark iso_arena_get_mark(iso_arena* arena);
+
+/*
+ * @brief Function to free everything allocated after the mark was taken
+ * @param arena = Pointer to the iso_arena
+ * @param mark  = Mark returned by iso_arena_get_mark
+ */
+
+ISO_API void iso_arena_rewind(iso_arena* arena, iso_arena_mark mark);
+
+/*
+ * @brief Function to free everything allocated from the arena. Chunks are kept for reuse.
+ * @param arena = Pointer to the iso_arena
+ */
+
+ISO_API void iso_arena_reset(iso_arena* arena);
+
+#endif // __ISO_ARENA_H__
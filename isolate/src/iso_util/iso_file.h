@@ -44,7 +44,9 @@ static iso_file* iso_file_read(char* path) {
 	}
 
 	file->size = __iso_file_get_size(f);
-	file->data = iso_alloc(file->size);
+	iso_memory_push_tag(ISO_MEMORY_TAG_ASSET);
+	file->data = iso_alloc_large(file->size);
+	iso_memory_pop_tag();
 	fread(file->data, file->size, 1, f);
 	file->data[file->size-1] = '\0';
 
@@ -74,7 +76,7 @@ static void iso_file_write(char* path, iso_file* file) {
  */
 
 static void iso_file_close(iso_file* file) {
-	iso_free(file->data);
+	iso_free_large(file->data);
 	iso_free(file);
 }
 
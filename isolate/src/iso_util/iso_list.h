@@ -12,6 +12,7 @@
  * @mem elements  = Pointer to the array of elements
  * @mem len       = Length of the list
  * @mem cap       = Maximum capacity of the list
+ * @mem align     = Alignment of the elements buffer (0 for the default alignment)
  * @mem tmp       = Temporary element for internal usage
  */
 
@@ -20,19 +21,53 @@
 		T* elements;     \
 		size_t len;      \
 		size_t cap;      \
+		size_t align;    \
 		T tmp;           \
 	}*
 
 
+/*
+ * @brief Macro to create an empty iso_list whose buffer is aligned to `a` bytes.
+ *        Use ISO_CACHE_LINE_SIZE to keep lists written by different threads off shared cache lines.
+ * @param list = iso_list structure
+ * @param a    = Alignment in bytes (power of two)
+ */
+
+#define iso_list_new_aligned(list, a)                                         \
+	do {                                                                        \
+		list = iso_alloc(sizeof(*list));                                          \
+		list->len = 0;                                                            \
+		list->cap = ISO_LIST_CAP;                                                 \
+		list->align = (a);                                                        \
+		list->elements = iso_alloc_aligned(sizeof(list->tmp) * list->cap, (a));   \
+	} while (0)
+
+
+/*
+ * @brief Internal macro to resize the buffer of the iso_list to its capacity
+ * @param list = iso_list structure
+ */
+
+#define __iso_list_resize(list)                                                                      \
+	do {                                                                                               \
+		if (list->align) {                                                                               \
+			list->elements = iso_realloc_aligned(list->elements, sizeof(list->tmp) * list->cap, list->align); \
+		} else {                                                                                         \
+			list->elements = iso_realloc(list->elements, sizeof(list->tmp) * list->cap);                   \
+		}                                                                                                \
+	} while (0)
+
+
 /*
  * @brief Macro to delete allocated iso_list
  * @param list = iso_list structure
  */
 
-#define iso_list_delete(list)  \
-	do {                         \
-		iso_free(list->elements);  \
-		iso_free(list);            \
+#define iso_list_delete(list)                                         \
+	do {                                                                \
+		if (list->align) iso_free_aligned(list->elements);                \
+		else             iso_free(list->elements);                        \
+		iso_free(list);                                                   \
 	} while(0)
 
 
@@ -49,23 +84,38 @@
 
 
 /*
- * @brief Macro to extend the capacity of the iso_list
+ * @brief Macro to extend the capacity of the iso_list.
+ *        Capacity doubles and the buffer is resized in place when possible.
  * @param list = iso_list structure
  */
 
-#define iso_list_extend(list)                                    \
-	do {                                                           \
-		void* tmp = iso_alloc(sizeof(list->tmp) * list->len);        \
-		memcpy(tmp, list->elements, sizeof(list->tmp) * list->len);  \
-		iso_free(list->elements);                                    \
-                                                                 \
-		list->cap += ISO_LIST_CAP;                                   \
-		list->elements = iso_alloc(sizeof(list->tmp) * list->cap);   \
-		memcpy(list->elements, tmp, sizeof(list->tmp) * list->len);  \
-		iso_free(tmp);                                               \
+#define iso_list_extend(list)                                \
+	do {                                                       \
+		list->cap = list->cap ? list->cap * 2 : ISO_LIST_CAP;    \
+		__iso_list_resize(list);                                 \
 	} while(0)
 
 
+/*
+ * @brief Macro to make sure the iso_list can hold `n` elements without growing
+ * @param list = iso_list structure
+ * @param n    = Capacity needed
+ */
+
+#define iso_list_reserve(list, n)                                                  \
+	do {                                                                             \
+		if (list == NULL) {                                                            \
+			list = iso_alloc(sizeof(*list));                                             \
+			list->len = 0;                                                               \
+			list->cap = 0;                                                               \
+		}                                                                              \
+		if (list->cap < (n)) {                                                         \
+			list->cap = (n);                                                             \
+			__iso_list_resize(list);                                                     \
+		}                                                                              \
+	} while (0)
+
+
 /*
  * @brief Macro to add new element to the iso_list
  * @param list = iso_list structure
@@ -1,118 +1,1081 @@
 #include "iso_memory.h"
+#include "iso_pool.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
 
 /*
- * @brief Memory structure for the custom allocator
- * @mem ptr  = Pointer to the data
- * @mem size = Size of the pointer in bytes
- * @mem file = File name where the pointer was created
- * @mem line = Line number where the pointer was created
+ * @brief Header placed in front of every tracked allocation.
+ *        Blocks are linked together so that alloc and free are O(1)
+ *        while the leak report can still walk every live block.
+ * @mem prev  = Previous live block
+ * @mem next  = Next live block
+ * @mem size  = Size of the pointer in bytes
+ * @mem file  = File name where the pointer was created
+ * @mem line   = Line number where the pointer was created
+ * @mem magic  = Marker used to validate pointers passed to iso_free (and to tell aligned and large blocks apart)
+ * @mem offset = Distance from the malloc'd pointer to the header (may be non-zero for aligned and large blocks)
+ * @mem site   = Profiler callsite of the block (0 if it was not profiled)
+ * @mem frame  = Profiler frame in which the block was allocated
+ * @mem shard  = Shard of the live list the block is linked into
+ * @mem tag    = iso_memory_tag the block is charged to
  */
 
-typedef struct {
-	void* ptr;
+typedef struct iso_memory_block iso_memory_block;
+struct iso_memory_block {
+	iso_memory_block* prev;
+	iso_memory_block* next;
 	size_t size;
 	const char* file;
 	i32 line;
-} iso_memory_block;
+	u32 magic;
+	u32 offset;
+	u32 site;
+	u32 frame;
+	u32 shard;
+	u32 tag;
+};
+
+#define ISO_MEMORY_MAGIC 0x150A110C
+#define ISO_MEMORY_LARGE_MAGIC 0x150A1A46
+#define ISO_MEMORY_ALIGNED_MAGIC 0x150A1A11
+
+// Header size rounded up so that the user pointer keeps malloc's alignment
+#define ISO_MEMORY_HEADER_SIZE ((sizeof(iso_memory_block) + 15) & ~((size_t) 15))
+
+#define __iso_block_to_ptr(block) ((void*) ((u8*) (block) + ISO_MEMORY_HEADER_SIZE))
+#define __iso_ptr_to_block(ptr)   ((iso_memory_block*) ((u8*) (ptr) - ISO_MEMORY_HEADER_SIZE))
+
+#define __iso_align_up(x, align) (((uintptr_t) (x) + ((align) - 1)) & ~((uintptr_t) (align) - 1))
 
 
 /*
- * @brief Memory manager that holds the allocated memory and tracks them.
- * @mem memory      = Array of memory blocks
- * @mem memory_cap  = Total memory capacitance
+ * @brief Allocation totals of a single callsite
+ * @mem file              = File of the callsite
+ * @mem line              = Line of the callsite
+ * @mem alloc_cnt         = Total allocations
+ * @mem free_cnt          = Total frees of blocks allocated here
+ * @mem frame_allocs      = Allocations in the current frame
+ * @mem peak_frame_allocs = Most allocations seen in a single frame
+ * @mem live_bytes        = Bytes currently allocated
+ * @mem peak_bytes        = High-water mark of live_bytes
+ * @mem total_bytes       = Bytes allocated in total
+ * @mem lifetime_sum      = Sum of the lifetimes (in frames) of the freed blocks
+ */
+
+typedef struct {
+	const char* file;
+	i32    line;
+	u64    alloc_cnt;
+	u64    free_cnt;
+	u32    frame_allocs;
+	u32    peak_frame_allocs;
+	size_t live_bytes;
+	size_t peak_bytes;
+	size_t total_bytes;
+	u64    lifetime_sum;
+} iso_memory_site;
+
+// No of independently locked live lists
+#define ISO_MEMORY_SHARD_CNT 16
+
+/*
+ * @brief Shard of the live block list. Every thread links its allocations into its
+ *        own shard, so threads only contend when they free each other's blocks.
+ * @mem lock        = Lock guarding the shard
+ * @mem head        = Sentinel of the circular list of live blocks
  * @mem memory_cnt  = No of memory allocated
  * @mem memory_size = Amount of memory allocated in bytes
  */
 
-#define ISO_MEMORY_CAP 1024
 typedef struct {
-	iso_memory_block* memory;
-	i32 memory_cap;
-	i32 memory_cnt;
-	i32 memory_size;
+	_Alignas(ISO_CACHE_LINE_SIZE) SDL_SpinLock lock;
+	iso_memory_block head;
+	size_t memory_cnt;
+	size_t memory_size;
+} iso_memory_shard;
+
+/*
+ * @brief Counters of a single tag. Each tag sits on its own cache line
+ *        since they are updated by every thread.
+ * @mem live        = Bytes currently allocated
+ * @mem peak        = High-water mark of live
+ * @mem budget      = Soft budget in bytes (0 if none)
+ * @mem alloc_cnt   = Total allocations
+ * @mem over_budget = True while live is over the budget (warns once per crossing)
+ * @mem name        = Name shown in the reports
+ */
+
+typedef struct {
+	_Alignas(ISO_CACHE_LINE_SIZE) size_t live;
+	size_t peak;
+	size_t budget;
+	u64    alloc_cnt;
+	b8     over_budget;
+	const char* name;
+} iso_memory_tag_counter;
+
+/*
+ * @brief Address range mapped from the OS for iso_alloc_large
+ * @mem ptr  = Start of the mapping
+ * @mem size = Size of the mapping in bytes (multiple of the page size)
+ */
+
+typedef struct {
+	void*  ptr;
+	size_t size;
+} iso_memory_mapping;
+
+/*
+ * @brief Memory manager that holds the allocated memory and tracks them.
+ * @mem shards      = Shards of the live block list
+ * @mem next_shard  = Counter used to hand out shards to new threads
+ * @mem tags        = Counters of every iso_memory_tag
+ * @mem large_cache = Released mappings kept for reuse (their pages are given back to the OS)
+ * @mem large_cnt   = No of mappings in `large_cache`
+ * @mem large_lock  = Lock guarding `large_cache`
+ * @mem pools       = List of registered pools
+ * @mem pools_lock  = Lock guarding the pool list
+ * @mem profile_lock = Lock guarding the profiler tables
+ * @mem profiling   = True while the allocation profiler is running
+ * @mem frame       = Frames closed since the profiler was first started
+ * @mem sites       = Callsites seen by the profiler (index 0 is unused)
+ * @mem site_cnt    = No of entries in `sites`
+ * @mem site_cap    = Capacity of `sites`
+ * @mem site_index  = Open addressing table from file:line to the index in `sites`
+ * @mem index_cap   = Capacity of `site_index` (power of two)
+ */
+
+typedef struct {
+	iso_memory_shard shards[ISO_MEMORY_SHARD_CNT];
+	SDL_atomic_t next_shard;
+	iso_memory_tag_counter tags[ISO_MEMORY_TAG_MAX];
+	iso_memory_mapping large_cache[ISO_MEMORY_LARGE_CACHE_CNT];
+	u32 large_cnt;
+	SDL_SpinLock large_lock;
+	iso_pool* pools;
+	SDL_SpinLock pools_lock;
+
+	SDL_SpinLock profile_lock;
+	b8  profiling;
+	u32 frame;
+	iso_memory_site* sites;
+	u32  site_cnt;
+	u32  site_cap;
+	u32* site_index;
+	u32  index_cap;
 } iso_memory_manager;
 
+// Static so that the shards get their cache line alignment
+static iso_memory_manager __iso_memory_manager;
 iso_memory_manager* manager;
 
+static const char* __iso_memory_tag_names[] = {
+	[ISO_MEMORY_TAG_GENERAL]  = "general",
+	[ISO_MEMORY_TAG_APP]      = "app",
+	[ISO_MEMORY_TAG_GRAPHICS] = "graphics",
+	[ISO_MEMORY_TAG_ECS]      = "ecs",
+	[ISO_MEMORY_TAG_SCENE]    = "scene",
+	[ISO_MEMORY_TAG_CAMERA]   = "camera",
+	[ISO_MEMORY_TAG_ASSET]    = "asset",
+	[ISO_MEMORY_TAG_USER]     = "user"
+};
+
+// Tags pushed by the calling thread
+static _Thread_local u32 __iso_memory_tag_stack[ISO_MEMORY_TAG_STACK_SIZE];
+static _Thread_local u32 __iso_memory_tag_depth;
+
 
 void iso_memory_init() {
-	manager = (iso_memory_manager*) malloc(sizeof(iso_memory_manager));
+	manager = &__iso_memory_manager;
 
-	manager->memory      = (iso_memory_block*) malloc(sizeof(iso_memory_block) * ISO_MEMORY_CAP);
-	manager->memory_cap  = 0;
-	manager->memory_cnt  = 0;
-	manager->memory_size = 0;
+	for (u32 i = 0; i < ISO_MEMORY_SHARD_CNT; i++) {
+		iso_memory_shard* shard = &manager->shards[i];
+		shard->lock        = 0;
+		shard->head.prev   = &shard->head;
+		shard->head.next   = &shard->head;
+		shard->memory_cnt  = 0;
+		shard->memory_size = 0;
+	}
+	SDL_AtomicSet(&manager->next_shard, 0);
+
+	for (u32 i = 0; i < ISO_MEMORY_TAG_MAX; i++) {
+		manager->tags[i] = (iso_memory_tag_counter) { 0 };
+		if (i < sizeof(__iso_memory_tag_names) / sizeof(__iso_memory_tag_names[0])) {
+			manager->tags[i].name = __iso_memory_tag_names[i];
+		}
+	}
+	manager->large_cnt   = 0;
+	manager->large_lock  = 0;
+	manager->pools       = NULL;
+	manager->pools_lock  = 0;
+
+	manager->profile_lock = 0;
+	manager->profiling  = false;
+	manager->frame      = 0;
+	manager->sites      = NULL;
+	manager->site_cnt   = 1;
+	manager->site_cap   = 0;
+	manager->site_index = NULL;
+	manager->index_cap  = 0;
 }
 
 void iso_print_mem(iso_memory_block* mem) {
-	printf("%p at %s:%d of %zu bytes\n", mem->ptr, mem->file, mem->line, mem->size);
+	printf("%p at %s:%d of %zu bytes\n", __iso_block_to_ptr(mem), mem->file, mem->line, mem->size);
+}
+
+/*
+ * @brief Function to print every live block
+ * @return Returns the no of live blocks
+ */
+
+static size_t __iso_print_live_blocks() {
+	size_t cnt = 0;
+	for (u32 i = 0; i < ISO_MEMORY_SHARD_CNT; i++) {
+		iso_memory_shard* shard = &manager->shards[i];
+		SDL_AtomicLock(&shard->lock);
+		for (iso_memory_block* mem = shard->head.next; mem != &shard->head; mem = mem->next) {
+			iso_print_mem(mem);
+		}
+		cnt += shard->memory_cnt;
+		SDL_AtomicUnlock(&shard->lock);
+	}
+	return cnt;
+}
+
+static size_t __iso_memory_live_cnt() {
+	size_t cnt = 0;
+	for (u32 i = 0; i < ISO_MEMORY_SHARD_CNT; i++) {
+		cnt += manager->shards[i].memory_cnt;
+	}
+	return cnt;
 }
 
 void iso_memory_alert() {
-	if (!manager->memory_cnt) return;
+	if (!__iso_memory_live_cnt()) return;
 
 	printf("\n---------Unfreed memories---------\n");
-	i32 i = 0;
-	for (i = 0; i < manager->memory_cnt; i++) {
-		iso_print_mem(&manager->memory[i]);
-	}
-	printf("\nTotal unfreed memories = %d\n", i+1);
+	size_t cnt = __iso_print_live_blocks();
+	printf("\nTotal unfreed memories = %zu\n", cnt);
 	printf("---------Unfreed memories---------\n\n");
 }
 
 void iso_print_mem_buffer() {
-	if (!manager->memory_cnt) return;
+	if (!__iso_memory_live_cnt()) return;
 
 	printf("\n---------Memory Buffer---------\n");
-		for (i32 i = 0; i < manager->memory_cnt; i++) {
-		iso_print_mem(&manager->memory[i]);
-	}
+	__iso_print_live_blocks();
 	printf("---------Memory Buffer---------\n\n");
+
+	iso_print_tag_stats();
+	iso_print_pool_stats();
 }
 
+void iso_memory_register_pool(iso_pool* pool) {
+	SDL_AtomicLock(&manager->pools_lock);
+	pool->next = manager->pools;
+	manager->pools = pool;
+	SDL_AtomicUnlock(&manager->pools_lock);
+}
+
+void iso_memory_unregister_pool(iso_pool* pool) {
+	SDL_AtomicLock(&manager->pools_lock);
+	iso_pool** it = &manager->pools;
+	while (*it != NULL && *it != pool) it = &(*it)->next;
+	if (*it != NULL) *it = pool->next;
+	SDL_AtomicUnlock(&manager->pools_lock);
+}
+
+b8 iso_memory_visit_pool(u32 id, void (*fn)(iso_pool* pool, void* data), void* data) {
+	SDL_AtomicLock(&manager->pools_lock);
+	iso_pool* pool = manager->pools;
+	while (pool != NULL && pool->id != id) pool = pool->next;
+	if (pool != NULL) fn(pool, data);
+	SDL_AtomicUnlock(&manager->pools_lock);
+	return pool != NULL;
+}
 
-void __iso_check_memory_bounds() {
-	if (manager->memory_cnt >= manager->memory_cap) {
-		// Create temp memory and copy the data
-		iso_memory_block* tmp_mem = (iso_memory_block*) malloc(sizeof(iso_memory_block) * (manager->memory_cap));
-		memcpy(tmp_mem, manager->memory, sizeof(iso_memory_block) * (manager->memory_cnt));
-		free(manager->memory);
+void iso_print_pool_stats() {
+	if (manager->pools == NULL) return;
 
-		// Delete old memory and create a new extended one and copy the data again
-		manager->memory_cap += ISO_MEMORY_CAP;
-		manager->memory = (iso_memory_block*) malloc(sizeof(iso_memory_block) * (manager->memory_cap));
-		memcpy(manager->memory, tmp_mem, sizeof(iso_memory_block) * (manager->memory_cnt));
-		free(tmp_mem);
+	printf("\n---------Memory Pools---------\n");
+	SDL_AtomicLock(&manager->pools_lock);
+	for (iso_pool* pool = manager->pools; pool != NULL; pool = pool->next) {
+		iso_pool_stats st = iso_pool_get_stats(pool);
+		printf("%s: %u/%u objects of %zu bytes live (peak %u), %zu bytes reserved\n",
+				st.name, st.live, st.capacity, st.obj_size, st.peak, st.bytes);
 	}
+	SDL_AtomicUnlock(&manager->pools_lock);
+	printf("---------Memory Pools---------\n\n");
 }
 
-void* __iso_alloc(size_t size, const char* file, i32 line) {
-	iso_memory_block mem = {
-		malloc(size),
-		size,
-		file,
-		line 
+
+void iso_memory_push_tag(u32 tag) {
+	iso_assert(tag < ISO_MEMORY_TAG_MAX, "Memory tag `%u` is out of range.\n", tag);
+	iso_assert(__iso_memory_tag_depth < ISO_MEMORY_TAG_STACK_SIZE, "Memory tags nested too deep.\n");
+	__iso_memory_tag_stack[__iso_memory_tag_depth++] = tag;
+}
+
+void iso_memory_pop_tag() {
+	iso_assert(__iso_memory_tag_depth > 0, "iso_memory_pop_tag called without a matching push.\n");
+	__iso_memory_tag_depth--;
+}
+
+u32 iso_memory_get_tag() {
+	return __iso_memory_tag_depth ? __iso_memory_tag_stack[__iso_memory_tag_depth - 1] : ISO_MEMORY_TAG_GENERAL;
+}
+
+void iso_memory_set_tag_name(u32 tag, const char* name) {
+	iso_assert(tag < ISO_MEMORY_TAG_MAX, "Memory tag `%u` is out of range.\n", tag);
+	manager->tags[tag].name = name;
+}
+
+void iso_memory_set_budget(u32 tag, size_t budget) {
+	iso_assert(tag < ISO_MEMORY_TAG_MAX, "Memory tag `%u` is out of range.\n", tag);
+	__atomic_store_n(&manager->tags[tag].budget, budget, __ATOMIC_RELAXED);
+}
+
+iso_memory_tag_stats iso_memory_get_tag_stats(u32 tag) {
+	iso_assert(tag < ISO_MEMORY_TAG_MAX, "Memory tag `%u` is out of range.\n", tag);
+	iso_memory_tag_counter* c = &manager->tags[tag];
+	return (iso_memory_tag_stats) {
+		.name      = c->name,
+		.live      = __atomic_load_n(&c->live, __ATOMIC_RELAXED),
+		.peak      = __atomic_load_n(&c->peak, __ATOMIC_RELAXED),
+		.budget    = __atomic_load_n(&c->budget, __ATOMIC_RELAXED),
+		.alloc_cnt = __atomic_load_n(&c->alloc_cnt, __ATOMIC_RELAXED)
 	};
-	memset(mem.ptr, 0, size);
+}
+
+void iso_print_tag_stats() {
+	printf("\n---------Memory Tags---------\n");
+	for (u32 i = 0; i < ISO_MEMORY_TAG_MAX; i++) {
+		iso_memory_tag_stats st = iso_memory_get_tag_stats(i);
+		if (!st.alloc_cnt && !st.budget) continue;
+
+		char name[32];
+		if (st.name) snprintf(name, sizeof(name), "%s", st.name);
+		else         snprintf(name, sizeof(name), "tag %u", i);
+
+		printf("%-12s %12zu bytes live (peak %zu)", name, st.live, st.peak);
+		if (st.budget) printf(", budget %zu", st.budget);
+		printf("\n");
+	}
+	printf("---------Memory Tags---------\n\n");
+}
+
+b8 iso_memory_is_tracking() {
+#ifdef ISO_MEMORY_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+#ifdef ISO_MEMORY_TRACKING
+
+/*
+ * The profiler's own tables are allocated with malloc so that they never show up in the reports.
+ */
+
+// Hashing the contents of `file`, the same file can be passed through different string literals
+static u32 __iso_memory_site_hash(const char* file, i32 line) {
+	u64 h = 0xCBF29CE484222325ull;
+	for (const char* c = file; *c; c++) h = (h ^ (u8) *c) * 0x100000001B3ull;
+	h = (h ^ (u32) line) * 0x9E3779B97F4A7C15ull;
+	return (u32) (h >> 32);
+}
+
+static void __iso_memory_site_index_grow() {
+	u32 cap = manager->index_cap ? manager->index_cap * 2 : 256;
+	u32* index = calloc(cap, sizeof(u32));
+	iso_assert(index, "Failed to grow the allocation profiler index\n");
+
+	for (u32 i = 1; i < manager->site_cnt; i++) {
+		iso_memory_site* site = &manager->sites[i];
+		u32 slot = __iso_memory_site_hash(site->file, site->line) & (cap - 1);
+		while (index[slot]) slot = (slot + 1) & (cap - 1);
+		index[slot] = i;
+	}
+
+	free(manager->site_index);
+	manager->site_index = index;
+	manager->index_cap  = cap;
+}
+
+/*
+ * @brief Function to find or create the callsite of an allocation
+ * @return Returns the index of the callsite in `manager->sites`
+ */
+
+static u32 __iso_memory_site_get(const char* file, i32 line) {
+	// Keeping the index at most 3/4 full
+	if ((manager->site_cnt + 1) * 4 >= manager->index_cap * 3) __iso_memory_site_index_grow();
+
+	u32 mask = manager->index_cap - 1;
+	u32 slot = __iso_memory_site_hash(file, line) & mask;
+	while (manager->site_index[slot]) {
+		iso_memory_site* site = &manager->sites[manager->site_index[slot]];
+		if (site->line == line && strcmp(site->file, file) == 0) return manager->site_index[slot];
+		slot = (slot + 1) & mask;
+	}
+
+	if (manager->site_cnt >= manager->site_cap) {
+		manager->site_cap = manager->site_cap ? manager->site_cap * 2 : 64;
+		manager->sites = realloc(manager->sites, sizeof(iso_memory_site) * manager->site_cap);
+		iso_assert(manager->sites, "Failed to grow the allocation profiler callsites\n");
+	}
+
+	u32 idx = manager->site_cnt++;
+	manager->sites[idx] = (iso_memory_site) { .file = file, .line = line };
+	manager->site_index[slot] = idx;
+	return idx;
+}
+
+static void __iso_memory_profile_alloc(iso_memory_block* mem) {
+	mem->site  = 0;
+	mem->frame = 0;
+	if (!manager->profiling) return;
+
+	SDL_AtomicLock(&manager->profile_lock);
+	mem->frame = manager->frame;
+	mem->site  = __iso_memory_site_get(mem->file, mem->line);
+	iso_memory_site* site = &manager->sites[mem->site];
+	site->alloc_cnt++;
+	site->frame_allocs++;
+	site->total_bytes += mem->size;
+	site->live_bytes  += mem->size;
+	if (site->live_bytes > site->peak_bytes) site->peak_bytes = site->live_bytes;
+	SDL_AtomicUnlock(&manager->profile_lock);
+}
+
+static void __iso_memory_profile_free(iso_memory_block* mem) {
+	if (!mem->site) return;
+
+	SDL_AtomicLock(&manager->profile_lock);
+	iso_memory_site* site = &manager->sites[mem->site];
+	site->free_cnt++;
+	site->live_bytes   -= mem->size;
+	site->lifetime_sum += manager->frame - mem->frame;
+	SDL_AtomicUnlock(&manager->profile_lock);
+}
+
+// Shard picked by the calling thread on its first allocation
+static _Thread_local i32 __iso_memory_thread_shard = -1;
+
+/*
+ * @brief Function to get the shard of the calling thread
+ * @return Returns the index of the shard
+ */
+
+static u32 __iso_memory_shard_idx() {
+	if (__iso_memory_thread_shard < 0) {
+		__iso_memory_thread_shard = (u32) SDL_AtomicAdd(&manager->next_shard, 1) % ISO_MEMORY_SHARD_CNT;
+	}
+	return __iso_memory_thread_shard;
+}
+
+/*
+ * @brief Function to charge bytes of a block to its tag, warns when the tag goes over its budget
+ */
+
+static void __iso_memory_tag_grow(iso_memory_block* mem, size_t bytes) {
+	iso_memory_tag_counter* c = &manager->tags[mem->tag];
+	size_t live = __atomic_add_fetch(&c->live, bytes, __ATOMIC_RELAXED);
+
+	size_t peak = __atomic_load_n(&c->peak, __ATOMIC_RELAXED);
+	while (live > peak && !__atomic_compare_exchange_n(&c->peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	size_t budget = __atomic_load_n(&c->budget, __ATOMIC_RELAXED);
+	if (budget && live > budget && !__atomic_exchange_n(&c->over_budget, true, __ATOMIC_RELAXED)) {
+		iso_log_warn("Memory tag `%s` is over its budget: %zu/%zu bytes (%s:%d)\n",
+				c->name ? c->name : "unnamed", live, budget, mem->file, mem->line);
+	}
+}
+
+/*
+ * @brief Function to give bytes of a block back to its tag, rearms the budget warning once under it
+ */
+
+static void __iso_memory_tag_shrink(iso_memory_block* mem, size_t bytes) {
+	iso_memory_tag_counter* c = &manager->tags[mem->tag];
+	size_t live = __atomic_sub_fetch(&c->live, bytes, __ATOMIC_RELAXED);
+
+	size_t budget = __atomic_load_n(&c->budget, __ATOMIC_RELAXED);
+	if (live <= budget && __atomic_load_n(&c->over_budget, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&c->over_budget, false, __ATOMIC_RELAXED);
+	}
+}
+
+static void __iso_memory_tag_alloc(iso_memory_block* mem) {
+	__atomic_add_fetch(&manager->tags[mem->tag].alloc_cnt, 1, __ATOMIC_RELAXED);
+	__iso_memory_tag_grow(mem, mem->size);
+}
+
+static void __iso_memory_tag_free(iso_memory_block* mem) {
+	__iso_memory_tag_shrink(mem, mem->size);
+}
+
+static void __iso_memory_link(iso_memory_block* mem) {
+	mem->shard = __iso_memory_shard_idx();
+	iso_memory_shard* shard = &manager->shards[mem->shard];
+
+	SDL_AtomicLock(&shard->lock);
+
+	// Linking at the tail so that the reports are in allocation order
+	mem->next = &shard->head;
+	mem->prev = shard->head.prev;
+	shard->head.prev->next = mem;
+	shard->head.prev = mem;
+
+	shard->memory_cnt++;
+	shard->memory_size += mem->size;
+
+	SDL_AtomicUnlock(&shard->lock);
+}
+
+static void __iso_memory_unlink(iso_memory_block* mem) {
+	iso_memory_shard* shard = &manager->shards[mem->shard];
+
+	SDL_AtomicLock(&shard->lock);
+
+	mem->prev->next = mem->next;
+	mem->next->prev = mem->prev;
+
+	shard->memory_cnt--;
+	shard->memory_size -= mem->size;
+
+	SDL_AtomicUnlock(&shard->lock);
+}
+
+/*
+ * @brief Function to fill the header of a new block and link it to the live list
+ * @param raw    = Pointer returned by malloc
+ * @param offset = Offset of the header from `raw`
+ * @param tag    = iso_memory_tag the block is charged to
+ * @return Returns the user pointer
+ */
+
+static void* __iso_memory_track(void* raw, size_t offset, u32 tag, size_t size, const char* file, i32 line) {
+	iso_memory_block* mem = (iso_memory_block*) ((u8*) raw + offset);
+
+	mem->size   = size;
+	mem->file   = file;
+	mem->line   = line;
+	mem->magic  = ISO_MEMORY_MAGIC;
+	mem->offset = offset;
+	mem->tag    = tag;
+	__iso_memory_profile_alloc(mem);
+	__iso_memory_link(mem);
+	__iso_memory_tag_alloc(mem);
+
+	return __iso_block_to_ptr(mem);
+}
+
+/*
+ * @brief Function to unlink the block of a user pointer from the live list
+ * @param ptr = User pointer
+ * @return Returns the pointer that was returned by malloc
+ */
+
+static void* __iso_memory_untrack(void* ptr) {
+	iso_memory_block* mem = __iso_ptr_to_block(ptr);
+	iso_assert(mem->magic == ISO_MEMORY_MAGIC || mem->magic == ISO_MEMORY_LARGE_MAGIC || mem->magic == ISO_MEMORY_ALIGNED_MAGIC, "Tried to free untracked or already freed pointer %p\n", ptr);
+
+	mem->magic = 0;
+	__iso_memory_unlink(mem);
+	__iso_memory_tag_free(mem);
+	__iso_memory_profile_free(mem);
+
+	return (u8*) mem - mem->offset;
+}
 
-	__iso_check_memory_bounds();
+static void* __iso_alloc_uninit_tagged(u32 tag, size_t size, const char* file, i32 line) {
+	void* raw = malloc(ISO_MEMORY_HEADER_SIZE + size);
+	iso_assert(raw, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+	return __iso_memory_track(raw, 0, tag, size, file, line);
+}
+
+void* __iso_alloc_uninit(size_t size, const char* file, i32 line) {
+	return __iso_alloc_uninit_tagged(iso_memory_get_tag(), size, file, line);
+}
+
+void* __iso_alloc(size_t size, const char* file, i32 line) {
+	void* ptr = __iso_alloc_uninit(size, file, line);
+	memset(ptr, 0, size);
+	return ptr;
+}
 
-	manager->memory[(manager->memory_cnt)++] = mem;
-	manager->memory_size += size;
-	return mem.ptr;
+void* __iso_alloc_tagged(u32 tag, size_t size, const char* file, i32 line) {
+	iso_assert(tag < ISO_MEMORY_TAG_MAX, "Memory tag `%u` is out of range at %s:%d\n", tag, file, line);
+	void* ptr = __iso_alloc_uninit_tagged(tag, size, file, line);
+	memset(ptr, 0, size);
+	return ptr;
 }
 
 void  __iso_free(void* ptr) {
-	for (i32 i = 0; i < manager->memory_cnt; i++) {
-		if (manager->memory[i].ptr == ptr) {
-			manager->memory_size -= manager->memory[i].size;
+	if (ptr == NULL) return;
+	iso_assert(__iso_ptr_to_block(ptr)->magic != ISO_MEMORY_LARGE_MAGIC, "Pointer %p must be freed with iso_free_large\n", ptr);
+	iso_assert(__iso_ptr_to_block(ptr)->magic != ISO_MEMORY_ALIGNED_MAGIC, "Pointer %p must be freed with iso_free_aligned\n", ptr);
+	free(__iso_memory_untrack(ptr));
+}
 
-			memmove(&manager->memory[i], &manager->memory[i+1], (manager->memory_cnt - i - 1) * sizeof(iso_memory_block));
+void* __iso_realloc(void* ptr, size_t size, const char* file, i32 line) {
+	if (ptr == NULL) return __iso_alloc_uninit(size, file, line);
 
-			manager->memory_cnt--;
+	iso_memory_block* mem = __iso_ptr_to_block(ptr);
+	iso_assert(mem->magic != ISO_MEMORY_ALIGNED_MAGIC, "Aligned pointer %p must be resized with iso_realloc_aligned\n", ptr);
+	iso_assert(mem->magic != ISO_MEMORY_LARGE_MAGIC, "Pointer %p from iso_alloc_large cant be resized, allocate a new large block instead\n", ptr);
+	iso_assert(mem->magic == ISO_MEMORY_MAGIC, "Tried to realloc untracked or freed pointer %p\n", ptr);
 
-			free(ptr);
-			break;
-		}
+	// The block may move, so it is unlinked while being resized
+	__iso_memory_unlink(mem);
+	__iso_memory_profile_free(mem);
+
+	size_t old_size = mem->size;
+	mem = (iso_memory_block*) realloc(mem, ISO_MEMORY_HEADER_SIZE + size);
+	iso_assert(mem, "Failed to reallocate %zu bytes at %s:%d\n", size, file, line);
+
+	mem->size = size;
+	mem->file = file;
+	mem->line = line;
+	__iso_memory_profile_alloc(mem);
+	__iso_memory_link(mem);
+
+	// The tag only sees the change in size, a resize is not a new allocation
+	if (size > old_size) __iso_memory_tag_grow(mem, size - old_size);
+	else __iso_memory_tag_shrink(mem, old_size - size);
+
+	return __iso_block_to_ptr(mem);
+}
+
+void* __iso_alloc_aligned(size_t size, size_t align, const char* file, i32 line) {
+	iso_assert(align && (align & (align - 1)) == 0, "Alignment `%zu` is not a power of two at %s:%d\n", align, file, line);
+
+	// Smaller alignments would leave the header misaligned
+	if (align < _Alignof(max_align_t)) align = _Alignof(max_align_t);
+
+	u8* raw = malloc(ISO_MEMORY_HEADER_SIZE + size + align - 1);
+	iso_assert(raw, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+
+	// Header sits right before the aligned user pointer
+	uintptr_t user = __iso_align_up(raw + ISO_MEMORY_HEADER_SIZE, align);
+	size_t offset = (user - ISO_MEMORY_HEADER_SIZE) - (uintptr_t) raw;
+
+	void* ptr = __iso_memory_track(raw, offset, iso_memory_get_tag(), size, file, line);
+	__iso_ptr_to_block(ptr)->magic = ISO_MEMORY_ALIGNED_MAGIC;
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void  __iso_free_aligned(void* ptr) {
+	if (ptr == NULL) return;
+	iso_assert(__iso_ptr_to_block(ptr)->magic == ISO_MEMORY_ALIGNED_MAGIC, "Pointer %p wasnt allocated with iso_alloc_aligned\n", ptr);
+	free(__iso_memory_untrack(ptr));
+}
+
+static size_t __iso_alloc_size(void* ptr) {
+	return __iso_ptr_to_block(ptr)->size;
+}
+
+void iso_memory_profiler_start() {
+	manager->profiling = true;
+}
+
+void iso_memory_profiler_stop() {
+	manager->profiling = false;
+}
+
+void iso_memory_profiler_next_frame() {
+	if (!manager->profiling) return;
+
+	SDL_AtomicLock(&manager->profile_lock);
+	for (u32 i = 1; i < manager->site_cnt; i++) {
+		iso_memory_site* site = &manager->sites[i];
+		if (site->frame_allocs > site->peak_frame_allocs) site->peak_frame_allocs = site->frame_allocs;
+		site->frame_allocs = 0;
+	}
+	manager->frame++;
+	SDL_AtomicUnlock(&manager->profile_lock);
+}
+
+static i32 __iso_memory_site_cmp(const void* a, const void* b) {
+	iso_memory_site* sa = &manager->sites[*(const u32*) a];
+	iso_memory_site* sb = &manager->sites[*(const u32*) b];
+	u64 ca = sa->alloc_cnt + sa->free_cnt;
+	u64 cb = sb->alloc_cnt + sb->free_cnt;
+	return (ca < cb) - (ca > cb);
+}
+
+void iso_memory_profiler_report(u32 top_n) {
+	SDL_AtomicLock(&manager->profile_lock);
+	if (manager->site_cnt <= 1) {
+		SDL_AtomicUnlock(&manager->profile_lock);
+		return;
 	}
+
+	// Sorting the callsites by churn (allocations + frees)
+	u32  cnt   = manager->site_cnt - 1;
+	u32* order = malloc(sizeof(u32) * cnt);
+	for (u32 i = 0; i < cnt; i++) order[i] = i + 1;
+	qsort(order, cnt, sizeof(u32), __iso_memory_site_cmp);
+	if (top_n == 0 || top_n > cnt) top_n = cnt;
+
+	f64 frames = manager->frame ? manager->frame : 1;
+
+	printf("\n---------Allocation Profile (%u frames)---------\n", manager->frame);
+	printf("%-48s %10s %10s %10s %12s %12s %10s\n",
+			"callsite", "allocs/f", "frees/f", "peak/f", "live", "peak", "life(f)");
+	for (u32 i = 0; i < top_n; i++) {
+		iso_memory_site* site = &manager->sites[order[i]];
+
+		char loc[256];
+		snprintf(loc, sizeof(loc), "%s:%d", site->file, site->line);
+
+		printf("%-48s %10.2f %10.2f %10u %12zu %12zu %10.2f\n",
+				loc,
+				site->alloc_cnt / frames,
+				site->free_cnt / frames,
+				site->peak_frame_allocs,
+				site->live_bytes,
+				site->peak_bytes,
+				site->free_cnt ? (f64) site->lifetime_sum / site->free_cnt : 0.0);
+	}
+	printf("---------Allocation Profile---------\n\n");
+	SDL_AtomicUnlock(&manager->profile_lock);
+
+	free(order);
+}
+
+void iso_memory_profiler_dump_csv(const char* path) {
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) {
+		iso_log_error("Failed to write allocation profile to `%s`: %s\n", path, strerror(errno));
+		return;
+	}
+
+	f64 frames = manager->frame ? manager->frame : 1;
+
+	SDL_AtomicLock(&manager->profile_lock);
+	fprintf(fp, "file,line,allocs,frees,allocs_per_frame,frees_per_frame,peak_allocs_per_frame,"
+	            "live_bytes,peak_bytes,total_bytes,avg_lifetime_frames\n");
+	for (u32 i = 1; i < manager->site_cnt; i++) {
+		iso_memory_site* site = &manager->sites[i];
+		fprintf(fp, "%s,%d,%llu,%llu,%f,%f,%u,%zu,%zu,%zu,%f\n",
+				site->file, site->line,
+				(unsigned long long) site->alloc_cnt,
+				(unsigned long long) site->free_cnt,
+				site->alloc_cnt / frames,
+				site->free_cnt / frames,
+				site->peak_frame_allocs,
+				site->live_bytes,
+				site->peak_bytes,
+				site->total_bytes,
+				site->free_cnt ? (f64) site->lifetime_sum / site->free_cnt : 0.0);
+	}
+	SDL_AtomicUnlock(&manager->profile_lock);
+	fclose(fp);
+}
+
+#else
+
+void* __iso_alloc_uninit(size_t size, const char* file, i32 line) {
+	void* ptr = malloc(size);
+	iso_assert(ptr || !size, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+	return ptr;
+}
+
+// Above this size calloc gets fresh pages from the OS and can skip the memset
+#define ISO_MEMORY_CALLOC_THRESHOLD (128 * 1024)
+
+void* __iso_alloc(size_t size, const char* file, i32 line) {
+	void* ptr;
+	if (size >= ISO_MEMORY_CALLOC_THRESHOLD) {
+		ptr = calloc(1, size);
+	} else {
+		// Small callocs skip glibc's thread cache. The empty asm keeps gcc
+		// from folding this malloc + memset back into a calloc.
+		ptr = malloc(size);
+	#if defined(__GNUC__)
+		__asm__ volatile("" : "+r"(ptr));
+	#endif
+		if (ptr) memset(ptr, 0, size);
+	}
+	iso_assert(ptr || !size, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+	return ptr;
+}
+
+void  __iso_free(void* ptr) {
+	free(ptr);
+}
+
+// Release builds have no headers to charge the tags with
+void* __iso_alloc_tagged(u32 tag, size_t size, const char* file, i32 line) {
+	(void) tag;
+	return __iso_alloc(size, file, line);
+}
+
+void* __iso_realloc(void* ptr, size_t size, const char* file, i32 line) {
+	void* res = realloc(ptr, size);
+	iso_assert(res || !size, "Failed to reallocate %zu bytes at %s:%d\n", size, file, line);
+	return res;
+}
+
+/*
+ * @brief Prefix stored right before an aligned pointer in release builds
+ * @mem raw  = Pointer returned by malloc
+ * @mem size = Size requested by the user
+ */
+
+typedef struct {
+	void*  raw;
+	size_t size;
+} iso_aligned_prefix;
+
+void* __iso_alloc_aligned(size_t size, size_t align, const char* file, i32 line) {
+	iso_assert(align && (align & (align - 1)) == 0, "Alignment `%zu` is not a power of two at %s:%d\n", align, file, line);
+
+	// Smaller alignments would leave the prefix misaligned
+	if (align < _Alignof(max_align_t)) align = _Alignof(max_align_t);
+
+	u8* raw = malloc(sizeof(iso_aligned_prefix) + size + align - 1);
+	iso_assert(raw, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+
+	void* ptr = (void*) __iso_align_up(raw + sizeof(iso_aligned_prefix), align);
+	iso_aligned_prefix* prefix = (iso_aligned_prefix*) ptr - 1;
+	prefix->raw  = raw;
+	prefix->size = size;
+
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void  __iso_free_aligned(void* ptr) {
+	if (ptr == NULL) return;
+	free(((iso_aligned_prefix*) ptr - 1)->raw);
+}
+
+static size_t __iso_alloc_size(void* ptr) {
+	return ((iso_aligned_prefix*) ptr - 1)->size;
+}
+
+// Release builds have no headers to attribute allocations with
+void iso_memory_profiler_start() {
+	iso_log_warn("Allocation profiler is only available in debug builds of the engine.\n");
+}
+
+void iso_memory_profiler_stop() {}
+void iso_memory_profiler_next_frame() {}
+void iso_memory_profiler_report(u32 top_n) { (void) top_n; }
+void iso_memory_profiler_dump_csv(const char* path) { (void) path; }
+
+#endif // ISO_MEMORY_TRACKING
+
+void* __iso_realloc_aligned(void* ptr, size_t size, size_t align, const char* file, i32 line) {
+	void* res = __iso_alloc_aligned(size, align, file, line);
+	if (ptr != NULL) {
+		size_t old_size = __iso_alloc_size(ptr);
+		memcpy(res, ptr, old_size < size ? old_size : size);
+		__iso_free_aligned(ptr);
+	}
+	return res;
+}
+
+/*
+ * Large blocks. Each one gets its own mapping laid out as
+ * [iso_memory_large_prefix | tracking header (debug) | data]
+ * so that the data stays cache line aligned.
+ */
+
+/*
+ * @brief Prefix at the start of every large mapping
+ * @mem map_size = Size of the mapping (0 if the block came from the heap)
+ */
+
+typedef struct {
+	size_t map_size;
+} iso_memory_large_prefix;
+
+#ifdef ISO_MEMORY_TRACKING
+	#define ISO_MEMORY_LARGE_PREFIX __iso_align_up(sizeof(iso_memory_large_prefix) + ISO_MEMORY_HEADER_SIZE, ISO_CACHE_LINE_SIZE)
+#else
+	#define ISO_MEMORY_LARGE_PREFIX __iso_align_up(sizeof(iso_memory_large_prefix), ISO_CACHE_LINE_SIZE)
+#endif
+
+// Mappings of at least this size are advised to use transparent huge pages
+#define ISO_MEMORY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static size_t __iso_page_size() {
+	static size_t page_size;
+	if (!page_size) {
+	#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		page_size = info.dwPageSize;
+	#else
+		page_size = sysconf(_SC_PAGESIZE);
+	#endif
+	}
+	return page_size;
+}
+
+/*
+ * @brief Function to map zeroed pages from the OS
+ * @return Returns the mapping or NULL on failure
+ */
+
+static void* __iso_os_map(size_t size) {
+#ifdef _WIN32
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED) return NULL;
+
+	#ifdef MADV_HUGEPAGE
+	if (size >= ISO_MEMORY_HUGE_PAGE_SIZE) madvise(ptr, size, MADV_HUGEPAGE);
+	#endif
+	return ptr;
+#endif
+}
+
+static void __iso_os_unmap(void* ptr, size_t size) {
+#ifdef _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+/*
+ * @brief Function to give the pages of a mapping back to the OS while keeping
+ *        the address range. The pages read as zero when touched again.
+ */
+
+static void __iso_os_release(void* ptr, size_t size) {
+#ifdef _WIN32
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+	madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
+/*
+ * @brief Function to make a released mapping usable again
+ * @return Returns false if the pages couldn't be committed
+ */
+
+static b8 __iso_os_reuse(void* ptr, size_t size) {
+#ifdef _WIN32
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	(void) ptr;
+	(void) size;
+	return true;
+#endif
+}
+
+/*
+ * @brief Function to get a mapping of at least `size` bytes, reusing a released one if possible
+ * @param size = Required size (multiple of the page size)
+ * @return Returns the mapping, its `ptr` is NULL on failure
+ */
+
+static iso_memory_mapping __iso_memory_large_map(size_t size) {
+	iso_memory_mapping map = { 0 };
+
+	// Taking the smallest cached mapping that fits
+	SDL_AtomicLock(&manager->large_lock);
+	i32 best = -1;
+	for (u32 i = 0; i < manager->large_cnt; i++) {
+		if (manager->large_cache[i].size < size) continue;
+		if (best < 0 || manager->large_cache[i].size < manager->large_cache[best].size) best = i;
+	}
+	if (best >= 0) {
+		map = manager->large_cache[best];
+		manager->large_cache[best] = manager->large_cache[--manager->large_cnt];
+	}
+	SDL_AtomicUnlock(&manager->large_lock);
+
+	if (map.ptr && !__iso_os_reuse(map.ptr, map.size)) {
+		__iso_os_unmap(map.ptr, map.size);
+		map.ptr = NULL;
+	}
+
+	if (map.ptr == NULL) {
+		map.ptr  = __iso_os_map(size);
+		map.size = size;
+	}
+	return map;
+}
+
+static void __iso_memory_large_unmap(void* ptr, size_t size) {
+	__iso_os_release(ptr, size);
+
+	SDL_AtomicLock(&manager->large_lock);
+	if (manager->large_cnt < ISO_MEMORY_LARGE_CACHE_CNT) {
+		manager->large_cache[manager->large_cnt++] = (iso_memory_mapping) { ptr, size };
+		ptr = NULL;
+	}
+	SDL_AtomicUnlock(&manager->large_lock);
+
+	if (ptr) __iso_os_unmap(ptr, size);
+}
+
+void* __iso_alloc_large(size_t size, const char* file, i32 line) {
+	u8* raw;
+	size_t map_size = 0;
+
+	if (size < ISO_MEMORY_LARGE_THRESHOLD) {
+		raw = malloc(ISO_MEMORY_LARGE_PREFIX + size);
+		iso_assert(raw, "Failed to allocate %zu bytes at %s:%d\n", size, file, line);
+		memset(raw + ISO_MEMORY_LARGE_PREFIX, 0, size);
+	} else {
+		size_t page = __iso_page_size();
+		iso_memory_mapping map = __iso_memory_large_map(((ISO_MEMORY_LARGE_PREFIX + size) + page - 1) / page * page);
+		iso_assert(map.ptr, "Failed to map %zu bytes at %s:%d\n", size, file, line);
+		raw = map.ptr;
+		map_size = map.size;
+	}
+	((iso_memory_large_prefix*) raw)->map_size = map_size;
+
+#ifdef ISO_MEMORY_TRACKING
+	void* ptr = __iso_memory_track(raw, ISO_MEMORY_LARGE_PREFIX - ISO_MEMORY_HEADER_SIZE, iso_memory_get_tag(), size, file, line);
+	__iso_ptr_to_block(ptr)->magic = ISO_MEMORY_LARGE_MAGIC;
+	return ptr;
+#else
+	return raw + ISO_MEMORY_LARGE_PREFIX;
+#endif
+}
+
+void  __iso_free_large(void* ptr) {
+	if (ptr == NULL) return;
+
+#ifdef ISO_MEMORY_TRACKING
+	iso_assert(__iso_ptr_to_block(ptr)->magic == ISO_MEMORY_LARGE_MAGIC, "Pointer %p wasnt allocated with iso_alloc_large\n", ptr);
+	u8* raw = __iso_memory_untrack(ptr);
+#else
+	u8* raw = (u8*) ptr - ISO_MEMORY_LARGE_PREFIX;
+#endif
+
+	size_t map_size = ((iso_memory_large_prefix*) raw)->map_size;
+	if (map_size) __iso_memory_large_unmap(raw, map_size);
+	else          free(raw);
+}
+
+void iso_memory_trim() {
+	SDL_AtomicLock(&manager->large_lock);
+	for (u32 i = 0; i < manager->large_cnt; i++) {
+		__iso_os_unmap(manager->large_cache[i].ptr, manager->large_cache[i].size);
+	}
+	manager->large_cnt = 0;
+	SDL_AtomicUnlock(&manager->large_lock);
+}
+
+void* __iso_calloc(size_t cnt, size_t size, const char* file, i32 line) {
+	iso_assert(size == 0 || cnt <= SIZE_MAX / size, "Allocation of %zu x %zu bytes overflows at %s:%d\n", cnt, size, file, line);
+	return __iso_alloc(cnt * size, file, line);
 }
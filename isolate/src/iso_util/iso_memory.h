@@ -5,6 +5,16 @@
 #include "iso_defines.h"
 #include "iso_log.h"
 
+/*
+ * @brief Allocations are tracked (leak reports, file:line) only in debug builds.
+ *        Release builds (ISO_BUILD_RELEASE from ipm's build_mode) go straight to the
+ *        system allocator. The mode is decided when the engine is compiled.
+ */
+
+#ifdef ISO_BUILD_DEBUG
+	#define ISO_MEMORY_TRACKING
+#endif
+
 /*
  * @Brief Initialize the memory stack for memory allocations
  *        Must initialize before doing any memory allocations!!
@@ -13,19 +23,103 @@
 ISO_API void iso_memory_init();
 
 /*
- * @brief Function to allocate `x` amount of bytes.
+ * @brief Function to allocate `x` amount of zeroed bytes.
  * @param x = sizeof the bytes needed to be allocated
  */
 
 #define iso_alloc(x) __iso_alloc(x, __FILE__, __LINE__)
 
 /*
- * @brief Function to free the allocated pointer
+ * @brief Function to allocate `x` amount of bytes without zeroing them.
+ * @param x = sizeof the bytes needed to be allocated
+ */
+
+#define iso_alloc_uninit(x) __iso_alloc_uninit(x, __FILE__, __LINE__)
+
+/*
+ * @brief Function to allocate a zeroed array of `cnt` elements of `size` bytes.
+ * @param cnt  = No of elements
+ * @param size = Size of each element
+ */
+
+#define iso_calloc(cnt, size) __iso_calloc(cnt, size, __FILE__, __LINE__)
+
+/*
+ * @brief Function to resize an allocation, growing in place when possible.
+ *        Bytes past the old size are not zeroed. A NULL pointer allocates.
+ * @param ptr  = pointer to be resized
+ * @param size = new size in bytes
+ */
+
+#define iso_realloc(ptr, size) __iso_realloc(ptr, size, __FILE__, __LINE__)
+
+// Size of a cache line, used to pad hot data that is written by different threads
+#define ISO_CACHE_LINE_SIZE 64
+
+/*
+ * @brief Function to allocate `size` zeroed bytes aligned to `align` (power of two).
+ *        Must be freed with iso_free_aligned.
+ * @param size  = sizeof the bytes needed to be allocated
+ * @param align = alignment of the returned pointer (raised to alignof(max_align_t) if smaller)
+ */
+
+#define iso_alloc_aligned(size, align) __iso_alloc_aligned(size, align, __FILE__, __LINE__)
+
+/*
+ * @brief Function to resize an aligned allocation. The content is copied
+ *        into a new aligned block. Bytes past the old size are zeroed.
+ * @param ptr   = pointer returned by iso_alloc_aligned (or NULL)
+ * @param size  = new size in bytes
+ * @param align = alignment of the returned pointer
+ */
+
+#define iso_realloc_aligned(ptr, size, align) __iso_realloc_aligned(ptr, size, align, __FILE__, __LINE__)
+
+/*
+ * @brief Function to free a pointer returned by iso_alloc_aligned. Freeing NULL does nothing.
+ * @param ptr = pointer to be freed
+ */
+
+#define iso_free_aligned(ptr) __iso_free_aligned(ptr)
+
+// Requests from this size on are mapped straight from the OS by iso_alloc_large
+#define ISO_MEMORY_LARGE_THRESHOLD (256 * 1024)
+
+// No of released mappings kept around for reuse by iso_alloc_large
+#define ISO_MEMORY_LARGE_CACHE_CNT 8
+
+/*
+ * @brief Function to allocate a large zeroed buffer (asset data, file contents).
+ *        Big requests get their own mapping from the OS: pages are zeroed lazily by
+ *        the kernel on first touch and huge pages are used when available.
+ *        Must be freed with iso_free_large and cant be resized with iso_realloc.
+ * @param size = sizeof the bytes needed to be allocated
+ */
+
+#define iso_alloc_large(size) __iso_alloc_large(size, __FILE__, __LINE__)
+
+/*
+ * @brief Function to free a buffer from iso_alloc_large. The pages are handed back
+ *        to the OS right away, the address range may be kept for the next large
+ *        allocation. Freeing NULL does nothing.
+ * @param ptr = pointer to be freed
+ */
+
+#define iso_free_large(ptr) __iso_free_large(ptr)
+
+/*
+ * @brief Function to free the allocated pointer. Freeing NULL does nothing.
  * @param ptr = pointer to be freed
  */
 
 #define iso_free(ptr) __iso_free(ptr)
 
+/*
+ * @brief Function to unmap the address ranges cached by iso_free_large
+ */
+
+ISO_API void iso_memory_trim();
+
 /*
  * @brief Function that alerts about the unfreed memory.
  *        Should be called at the end of program to notify all the
@@ -40,12 +134,210 @@ ISO_API void iso_memory_alert();
 
 ISO_API void iso_print_mem_buffer();
 
+/*
+ * @brief Function to check if the engine was built with allocation tracking
+ * @return Returns true for debug builds of the engine
+ */
+
+ISO_API b8 iso_memory_is_tracking();
+
+
+/*
+ * @brief Pools are registered to the memory manager so that their
+ *        occupancy shows up in the memory reports. (See iso_pool.h)
+ */
+
+typedef struct iso_pool iso_pool;
+
+/*
+ * @brief Function to register a pool to the memory reports. Called by iso_pool_new.
+ * @param pool = Pointer to the iso_pool
+ */
+
+ISO_API void iso_memory_register_pool(iso_pool* pool);
+
+/*
+ * @brief Function to remove a pool from the memory reports. Called by iso_pool_delete.
+ * @param pool = Pointer to the iso_pool
+ */
+
+ISO_API void iso_memory_unregister_pool(iso_pool* pool);
+
+/*
+ * @brief Function to run a callback on a registered pool. The pool cant be unregistered
+ *        (and so deleted) while the callback runs, the callback must not register or
+ *        unregister pools.
+ * @param id   = Id of the iso_pool
+ * @param fn   = Callback run with the pool
+ * @param data = User data passed to the callback
+ * @return Returns false if no pool with the id is registered (it was deleted)
+ */
+
+ISO_API b8 iso_memory_visit_pool(u32 id, void (*fn)(iso_pool* pool, void* data), void* data);
+
+/*
+ * @brief Function to print the occupancy and high-water mark of every registered pool
+ */
+
+ISO_API void iso_print_pool_stats();
+
+
+/*
+ * @brief Tags that attribute allocations to a subsystem (debug builds only).
+ *        Plain allocations take the innermost tag pushed by the calling thread,
+ *        so helpers like iso_str_new or iso_hmap_add are charged to the subsystem
+ *        that called them. Tags from ISO_MEMORY_TAG_USER up to ISO_MEMORY_TAG_MAX
+ *        are free for user code.
+ */
+
+typedef enum {
+	ISO_MEMORY_TAG_GENERAL,
+	ISO_MEMORY_TAG_APP,
+	ISO_MEMORY_TAG_GRAPHICS,
+	ISO_MEMORY_TAG_ECS,
+	ISO_MEMORY_TAG_SCENE,
+	ISO_MEMORY_TAG_CAMERA,
+	ISO_MEMORY_TAG_ASSET,
+	ISO_MEMORY_TAG_USER
+} iso_memory_tag;
+
+#define ISO_MEMORY_TAG_MAX 32
+
+// Max depth of nested iso_memory_push_tag calls per thread
+#define ISO_MEMORY_TAG_STACK_SIZE 16
+
+/*
+ * @brief Live usage of a tag
+ * @mem name      = Name of the tag
+ * @mem live      = Bytes currently allocated
+ * @mem peak      = High-water mark of live
+ * @mem budget    = Soft budget in bytes (0 if none)
+ * @mem alloc_cnt = Total allocations made with the tag
+ */
+
+typedef struct {
+	const char* name;
+	size_t live;
+	size_t peak;
+	size_t budget;
+	u64    alloc_cnt;
+} iso_memory_tag_stats;
+
+/*
+ * @brief Function to allocate `size` zeroed bytes charged to `tag`.
+ * @param tag  = iso_memory_tag
+ * @param size = sizeof the bytes needed to be allocated
+ */
+
+#define iso_alloc_tagged(tag, size) __iso_alloc_tagged(tag, size, __FILE__, __LINE__)
+
+/*
+ * @brief Function to charge the following allocations of the calling thread to `tag`
+ * @param tag = iso_memory_tag
+ */
+
+ISO_API void iso_memory_push_tag(u32 tag);
+
+/*
+ * @brief Function to restore the tag that was active before the last iso_memory_push_tag
+ */
+
+ISO_API void iso_memory_pop_tag();
+
+/*
+ * @brief Function to get the tag the calling thread currently allocates with
+ * @return Returns the tag
+ */
+
+ISO_API u32 iso_memory_get_tag();
+
+/*
+ * @brief Function to name a tag in the reports
+ * @param tag  = iso_memory_tag
+ * @param name = Name of the tag (must outlive the tag)
+ */
+
+ISO_API void iso_memory_set_tag_name(u32 tag, const char* name);
+
+/*
+ * @brief Function to set a soft budget. A warning is logged when the tag goes over it.
+ * @param tag    = iso_memory_tag
+ * @param budget = Budget in bytes (0 removes it)
+ */
+
+ISO_API void iso_memory_set_budget(u32 tag, size_t budget);
+
+/*
+ * @brief Function to get the live usage of a tag. Cheap enough to call every frame.
+ * @param tag = iso_memory_tag
+ * @return Returns iso_memory_tag_stats
+ */
+
+ISO_API iso_memory_tag_stats iso_memory_get_tag_stats(u32 tag);
+
+/*
+ * @brief Function to print the usage of every tag that was used
+ */
+
+ISO_API void iso_print_tag_stats();
+
+/*
+ * @brief Allocation profiler (debug builds only). While running, every tracked
+ *        allocation is aggregated per callsite (file:line): allocations and frees
+ *        per frame, live and peak bytes and the average lifetime in frames.
+ *        Used to hunt down hidden per-frame allocations.
+ */
+
+// Default amount of callsites printed by iso_memory_profiler_report
+#define ISO_MEMORY_PROFILE_TOP_N 16
+
+/*
+ * @brief Function to start (or resume) aggregating allocations per callsite
+ */
+
+ISO_API void iso_memory_profiler_start();
+
+/*
+ * @brief Function to pause the profiler. Frees of profiled blocks are still counted.
+ */
+
+ISO_API void iso_memory_profiler_stop();
+
+/*
+ * @brief Function to close the current frame of the profiler. Called by the main loop.
+ */
+
+ISO_API void iso_memory_profiler_next_frame();
+
+/*
+ * @brief Function to print the callsites with the most allocations per frame
+ * @param top_n = Max no of callsites to print (0 prints all)
+ */
+
+ISO_API void iso_memory_profiler_report(u32 top_n);
+
+/*
+ * @brief Function to write the totals of every callsite to a CSV file
+ * @param path = Path of the CSV file
+ */
+
+ISO_API void iso_memory_profiler_dump_csv(const char* path);
+
 
 /*
  * @brief Internal memory functions
  */
 
 ISO_API void* __iso_alloc(size_t size, const char* file, i32 line);
+ISO_API void* __iso_alloc_uninit(size_t size, const char* file, i32 line);
+ISO_API void* __iso_alloc_tagged(u32 tag, size_t size, const char* file, i32 line);
+ISO_API void* __iso_calloc(size_t cnt, size_t size, const char* file, i32 line);
+ISO_API void* __iso_realloc(void* ptr, size_t size, const char* file, i32 line);
+ISO_API void* __iso_alloc_aligned(size_t size, size_t align, const char* file, i32 line);
+ISO_API void* __iso_realloc_aligned(void* ptr, size_t size, size_t align, const char* file, i32 line);
+ISO_API void  __iso_free_aligned(void* ptr);
+ISO_API void* __iso_alloc_large(size_t size, const char* file, i32 line);
+ISO_API void  __iso_free_large(void* ptr);
 ISO_API void  __iso_free(void* ptr);
 
 
@@ -0,0 +1,204 @@
+#include "iso_pool.h"
+
+/*
+ * @brief Per-thread cache of free objects of a single pool
+ * @mem pool    = Pool the cached objects belong to
+ * @mem id      = Id of that pool, the pointer alone can be reused by a newer pool
+ * @mem head    = List of cached objects
+ * @mem cnt     = No of cached objects
+ */
+
+typedef struct {
+	iso_pool* pool;
+	u32       id;
+	void*     head;
+	u32       cnt;
+} iso_pool_tcache;
+
+#define ISO_POOL_TCACHE_SLOTS 16
+
+static _Thread_local iso_pool_tcache __iso_pool_tcaches[ISO_POOL_TCACHE_SLOTS];
+static SDL_atomic_t __iso_pool_next_id;
+
+// Intrusive free list link stored inside free objects
+#define __iso_pool_next(obj) (*(void**) (obj))
+
+#define __iso_pool_slab_header_size (((sizeof(iso_pool_slab) + ISO_POOL_ALIGN - 1) / ISO_POOL_ALIGN) * ISO_POOL_ALIGN)
+
+
+static void __iso_pool_lock(iso_pool* pool) {
+	if (pool->thread_safe) SDL_AtomicLock(&pool->lock);
+}
+
+static void __iso_pool_unlock(iso_pool* pool) {
+	if (pool->thread_safe) SDL_AtomicUnlock(&pool->lock);
+}
+
+static void __iso_pool_grow(iso_pool* pool) {
+	iso_memory_push_tag(pool->tag);
+	iso_pool_slab* slab = iso_alloc_uninit(__iso_pool_slab_header_size + pool->obj_size * pool->objs_per_slab);
+	iso_memory_pop_tag();
+	slab->next  = pool->slabs;
+	pool->slabs = slab;
+	pool->slab_cnt++;
+
+	// Threading the objects of the slab into the free list
+	u8* objs = (u8*) slab + __iso_pool_slab_header_size;
+	for (i64 i = pool->objs_per_slab - 1; i >= 0; i--) {
+		void* obj = objs + i * pool->obj_size;
+		__iso_pool_next(obj) = pool->free_list;
+		pool->free_list = obj;
+	}
+}
+
+static void __iso_pool_flush_visit(iso_pool* pool, void* data) {
+	(void) data;
+	iso_pool_flush_thread_cache(pool);
+}
+
+/*
+ * @brief Gets the thread cache slot of the pool and hands the objects of the previous owner back.
+ *        The owner may have been deleted by another thread, it is only touched through
+ *        iso_memory_visit_pool so that it cant be deleted during the flush. Objects of a
+ *        deleted owner are dropped, they were freed along with its slabs.
+ */
+
+static iso_pool_tcache* __iso_pool_tcache_claim(iso_pool* pool) {
+	iso_pool_tcache* cache = &__iso_pool_tcaches[pool->id % ISO_POOL_TCACHE_SLOTS];
+	if (cache->pool != pool || cache->id != pool->id) {
+		if (cache->pool != NULL) iso_memory_visit_pool(cache->id, __iso_pool_flush_visit, NULL);
+		cache->pool = pool;
+		cache->id   = pool->id;
+		cache->head = NULL;
+		cache->cnt  = 0;
+	}
+	return cache;
+}
+
+static void __iso_pool_track_alloc(iso_pool* pool) {
+	i32 live = SDL_AtomicAdd(&pool->live_cnt, 1) + 1;
+	i32 peak = SDL_AtomicGet(&pool->peak_cnt);
+	while (live > peak && !SDL_AtomicCAS(&pool->peak_cnt, peak, live)) {
+		peak = SDL_AtomicGet(&pool->peak_cnt);
+	}
+}
+
+iso_pool* iso_pool_new(iso_pool_def def) {
+	iso_assert(def.obj_size > 0, "Pool `%s` created with object size of 0.\n", def.name);
+
+	iso_pool* pool = iso_alloc(sizeof(iso_pool));
+	pool->name          = def.name;
+	pool->obj_size      = ((def.obj_size + ISO_POOL_ALIGN - 1) / ISO_POOL_ALIGN) * ISO_POOL_ALIGN;
+	pool->objs_per_slab = def.objs_per_slab ? def.objs_per_slab : ISO_POOL_SLAB_OBJ_CNT;
+	pool->thread_safe   = def.thread_safe;
+	pool->tag           = iso_memory_get_tag();
+	pool->id            = SDL_AtomicAdd(&__iso_pool_next_id, 1);
+
+	iso_memory_register_pool(pool);
+	return pool;
+}
+
+void iso_pool_delete(iso_pool* pool) {
+	iso_pool_flush_thread_cache(pool);
+	iso_memory_unregister_pool(pool);
+
+	iso_pool_slab* slab = pool->slabs;
+	while (slab != NULL) {
+		iso_pool_slab* next = slab->next;
+		iso_free(slab);
+		slab = next;
+	}
+	iso_free(pool);
+}
+
+void* iso_pool_alloc(iso_pool* pool) {
+	void* obj = NULL;
+
+	if (pool->thread_safe) {
+		// Slot is owned by another pool, handing its objects back
+		iso_pool_tcache* cache = __iso_pool_tcache_claim(pool);
+
+		// Refilling the thread cache with a batch from the shared free list
+		if (cache->cnt == 0) {
+			__iso_pool_lock(pool);
+			for (u32 i = 0; i < ISO_POOL_TCACHE_BATCH; i++) {
+				if (pool->free_list == NULL) __iso_pool_grow(pool);
+				void* o = pool->free_list;
+				pool->free_list = __iso_pool_next(o);
+				__iso_pool_next(o) = cache->head;
+				cache->head = o;
+				cache->cnt++;
+			}
+			__iso_pool_unlock(pool);
+		}
+
+		obj = cache->head;
+		cache->head = __iso_pool_next(obj);
+		cache->cnt--;
+	} else {
+		if (pool->free_list == NULL) __iso_pool_grow(pool);
+		obj = pool->free_list;
+		pool->free_list = __iso_pool_next(obj);
+	}
+
+	__iso_pool_track_alloc(pool);
+	memset(obj, 0, pool->obj_size);
+	return obj;
+}
+
+void iso_pool_free(iso_pool* pool, void* ptr) {
+	if (ptr == NULL) return;
+	SDL_AtomicAdd(&pool->live_cnt, -1);
+
+	if (pool->thread_safe) {
+		iso_pool_tcache* cache = __iso_pool_tcache_claim(pool);
+
+		__iso_pool_next(ptr) = cache->head;
+		cache->head = ptr;
+		cache->cnt++;
+
+		// Keeping the cache bounded so that memory can move between threads
+		if (cache->cnt >= 2 * ISO_POOL_TCACHE_BATCH) {
+			__iso_pool_lock(pool);
+			for (u32 i = 0; i < ISO_POOL_TCACHE_BATCH; i++) {
+				void* o = cache->head;
+				cache->head = __iso_pool_next(o);
+				__iso_pool_next(o) = pool->free_list;
+				pool->free_list = o;
+			}
+			cache->cnt -= ISO_POOL_TCACHE_BATCH;
+			__iso_pool_unlock(pool);
+		}
+	} else {
+		__iso_pool_next(ptr) = pool->free_list;
+		pool->free_list = ptr;
+	}
+}
+
+void iso_pool_flush_thread_cache(iso_pool* pool) {
+	iso_pool_tcache* cache = &__iso_pool_tcaches[pool->id % ISO_POOL_TCACHE_SLOTS];
+	if (cache->pool != pool || cache->id != pool->id) return;
+
+	__iso_pool_lock(pool);
+	while (cache->head != NULL) {
+		void* o = cache->head;
+		cache->head = __iso_pool_next(o);
+		__iso_pool_next(o) = pool->free_list;
+		pool->free_list = o;
+	}
+	__iso_pool_unlock(pool);
+
+	cache->cnt  = 0;
+	cache->pool = NULL;
+}
+
+iso_pool_stats iso_pool_get_stats(iso_pool* pool) {
+	return (iso_pool_stats) {
+		.name     = pool->name,
+		.obj_size = pool->obj_size,
+		.capacity = pool->slab_cnt * pool->objs_per_slab,
+		.live     = SDL_AtomicGet(&pool->live_cnt),
+		.peak     = SDL_AtomicGet(&pool->peak_cnt),
+		.bytes    = pool->slab_cnt * (__iso_pool_slab_header_size + pool->obj_size * pool->objs_per_slab)
+	};
+}
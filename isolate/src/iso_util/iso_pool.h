@@ -0,0 +1,146 @@
+#ifndef __ISO_POOL_H__
+#define __ISO_POOL_H__
+
+#include "iso_includes.h"
+#include "iso_defines.h"
+#include "iso_memory.h"
+
+// Objects are rounded up to this size class granularity
+#define ISO_POOL_ALIGN 16
+
+// Default amount of objects in a single slab
+#define ISO_POOL_SLAB_OBJ_CNT 64
+
+// Amount of objects moved between the pool and a thread cache at once
+#define ISO_POOL_TCACHE_BATCH 32
+
+/*
+ * @brief Slab of memory that is split into objects of the pool
+ * @mem next = Next slab of the pool
+ */
+
+typedef struct iso_pool_slab iso_pool_slab;
+struct iso_pool_slab {
+	iso_pool_slab* next;
+};
+
+/*
+ * @brief Definition of the pool
+ * @mem name          = Name of the pool shown in the reports
+ * @mem obj_size      = Size of a single object in bytes
+ * @mem objs_per_slab = Objects per slab (ISO_POOL_SLAB_OBJ_CNT if 0)
+ * @mem thread_safe   = Guards the pool with a lock and serves objects from per-thread caches
+ */
+
+typedef struct {
+	char*  name;
+	size_t obj_size;
+	u32    objs_per_slab;
+	b8     thread_safe;
+} iso_pool_def;
+
+/*
+ * @brief Fixed size object allocator. Freed objects are kept in an intrusive free list.
+ * @mem name          = Name of the pool
+ * @mem obj_size      = Size class of the objects
+ * @mem objs_per_slab = Objects per slab
+ * @mem thread_safe   = True if the pool is locked and uses thread caches
+ * @mem slabs         = List of the allocated slabs
+ * @mem free_list     = List of free objects
+ * @mem slab_cnt      = No of slabs allocated
+ * @mem live_cnt      = No of objects currently handed out
+ * @mem peak_cnt      = High-water mark of live_cnt
+ * @mem lock          = Lock guarding the slabs and free list
+ * @mem tag           = iso_memory_tag the slabs are charged to (the tag active at creation)
+ * @mem id            = Unique id of the pool (never reused), used to pick the thread cache slot
+ * @mem next          = Next registered pool (used by the memory reports)
+ */
+
+typedef struct iso_pool iso_pool;
+struct iso_pool {
+	char*  name;
+	size_t obj_size;
+	u32    objs_per_slab;
+	b8     thread_safe;
+
+	iso_pool_slab* slabs;
+	void*          free_list;
+	u32            slab_cnt;
+	SDL_atomic_t   live_cnt;
+	SDL_atomic_t   peak_cnt;
+	SDL_SpinLock   lock;
+
+	u32       tag;
+	u32       id;
+	iso_pool* next;
+};
+
+/*
+ * @brief Occupancy of the pool
+ * @mem name     = Name of the pool
+ * @mem obj_size = Size class of the objects
+ * @mem capacity = No of objects the allocated slabs can hold
+ * @mem live     = No of objects currently handed out
+ * @mem peak     = High-water mark of live objects
+ * @mem bytes    = Bytes reserved by the slabs
+ */
+
+typedef struct {
+	char*  name;
+	size_t obj_size;
+	u32    capacity;
+	u32    live;
+	u32    peak;
+	size_t bytes;
+} iso_pool_stats;
+
+
+/*
+ * @brief Function to create a new pool. The pool is registered to the memory reports.
+ * @param def = Definition of the pool
+ * @return Returns pointer to the iso_pool
+ */
+
+ISO_API iso_pool* iso_pool_new(iso_pool_def def);
+
+/*
+ * @brief Function to delete the pool and all of its slabs. Objects cached by other
+ *        threads are dropped the next time those threads use their cache slot,
+ *        the pool must not be used by other threads while it is deleted.
+ * @param pool = Pointer to the iso_pool
+ */
+
+ISO_API void iso_pool_delete(iso_pool* pool);
+
+/*
+ * @brief Function to allocate a zeroed object from the pool
+ * @param pool = Pointer to the iso_pool
+ * @return Returns pointer to the object
+ */
+
+ISO_API void* iso_pool_alloc(iso_pool* pool);
+
+/*
+ * @brief Function to return an object to the pool
+ * @param pool = Pointer to the iso_pool
+ * @param ptr  = Object allocated from the pool
+ */
+
+ISO_API void iso_pool_free(iso_pool* pool, void* ptr);
+
+/*
+ * @brief Function to give the objects cached by the calling thread back to the pool
+ * @param pool = Pointer to the iso_pool
+ */
+
+ISO_API void iso_pool_flush_thread_cache(iso_pool* pool);
+
+/*
+ * @brief Function to get the occupancy of the pool
+ * @param pool = Pointer to the iso_pool
+ * @return Returns iso_pool_stats
+ */
+
+ISO_API iso_pool_stats iso_pool_get_stats(iso_pool* pool);
+
+#endif // __ISO_POOL_H__
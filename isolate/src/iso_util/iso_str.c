@@ -8,71 +8,53 @@ typedef enum {
 	ISO_STR_CAP = -2
 } iso_str_meta;
 
-#define LEN ISO_STR_LEN * sizeof(iso_str_meta)
-#define CAP ISO_STR_CAP * sizeof(iso_str_meta)
+// Length and capacity are stored as i32s right before the characters
+#define META_SZ (2 * sizeof(i32))
+#define LEN(str) (((i32*) (str))[ISO_STR_LEN])
+#define CAP(str) (((i32*) (str))[ISO_STR_CAP])
 
 
 iso_str __iso_str_new(char* c_str, char* file, u32 line) {
-	u32 meta_size = 2 * sizeof(iso_str_meta);
 	u32 len = strlen(c_str);
-	u32 size = len + meta_size;
+	u32 size = META_SZ + len + 1;
 
-	iso_str str = __iso_alloc(size, file, line);
-	str += meta_size;
+	iso_str str = __iso_alloc_uninit(size, file, line);
+	str += META_SZ;
 
-	str[LEN] = len;
-	str[CAP] = len;
+	LEN(str) = len;
+	CAP(str) = len;
 
-	strncpy(str, c_str, len);
+	memcpy(str, c_str, len);
 	str[len] = '\0';
 
 	return str;
 }
 
 void iso_str_delete(iso_str str) {
-	u32 meta_size = 2 * sizeof(iso_str_meta);
-	str -= meta_size;
-	iso_free(str);
+	iso_free(str - META_SZ);
 }
 
 i32 iso_str_len(iso_str str) {
-	return (i32) str[LEN];
+	return LEN(str);
 }
 
 i32 iso_str_cap(iso_str str) {
-	return (i32) str[CAP];
+	return CAP(str);
 }
 
 void iso_str_clear(iso_str* str) {
-	i32 l = iso_str_len(*str);
 	i32 c = iso_str_cap(*str);
-	memset(*str, 0, c);
-	(*str)[LEN] = 0;
-	(*str)[l] = '\0';
+	memset(*str, 0, c + 1);
+	LEN(*str) = 0;
 }
 
 void iso_str_extend(iso_str* str, u32 amt) {
-	i32 cap = iso_str_cap(*str);
-	i32 len = iso_str_len(*str);
+	i32 cap = iso_str_cap(*str) + amt;
 
-	char* tmp = iso_alloc(cap);
-	strncpy(tmp, *str, len);
-	iso_str_delete(*str);
-
-	cap += amt;
-
-	// Creating new string
-	i32 meta_sz = 2 * sizeof(iso_str_meta);
-	i32 new_sz = cap + meta_sz;
-	*str = iso_alloc(new_sz);
-	(*str) += meta_sz;
-
-	(*str)[LEN] = len;
-	(*str)[CAP] = cap;
-	strncpy(*str, tmp, len);
-	(*str)[len] = '\0';
-
-	iso_free(tmp);
+	// Growing the whole block (meta + characters) in place when possible
+	char* block = iso_realloc(*str - META_SZ, META_SZ + cap + 1);
+	*str = block + META_SZ;
+	CAP(*str) = cap;
 }
 
 void iso_str_cpy(iso_str* dest, iso_str src) {
@@ -89,7 +71,7 @@ void iso_str_cpy(iso_str* dest, iso_str src) {
 
 	// Changing the length
 	dl = sl;
-	(*dest)[LEN] = dl;
+	LEN(*dest) = dl;
 	(*dest)[dl] = '\0';
 }
 
@@ -109,7 +91,7 @@ void iso_str_cat(iso_str* dest, iso_str src) {
 	printf("DEST: %s\n", *dest);
 
 	dl += sl;
-	(*dest)[LEN] = dl;
+	LEN(*dest) = dl;
 	(*dest)[dl] = '\0';
 }
 
@@ -0,0 +1,192 @@
+#include "iso_thread_pool.h"
+
+// Index of the calling thread inside its pool (0 if not a worker)
+static _Thread_local u32 __iso_thread_pool_worker_index;
+
+// Set while the calling thread runs jobs, nested batches run inline
+static _Thread_local b8 __iso_thread_pool_in_job;
+
+
+/*
+ * @brief Claims and runs jobs of the batch until none are left
+ * @return Returns the no of jobs run
+ */
+
+static u32 __iso_thread_pool_work(iso_thread_pool* pool, iso_thread_job* jobs, u32 cnt) {
+	u32 done = 0;
+	i32 i;
+
+	__iso_thread_pool_in_job = true;
+	while ((u32) (i = SDL_AtomicAdd(&pool->next, 1)) < cnt) {
+		iso_thread_job* job = &jobs[i];
+		job->fn(job->data, job->start, job->end);
+		done++;
+	}
+	__iso_thread_pool_in_job = false;
+
+	return done;
+}
+
+static i32 __iso_thread_pool_worker(void* data) {
+	iso_thread_worker* worker = data;
+	iso_thread_pool* pool = worker->pool;
+	__iso_thread_pool_worker_index = worker->index;
+
+	u32 seen = 0;
+	SDL_LockMutex(pool->lock);
+	for (;;) {
+		while (!pool->quit && pool->generation == seen) {
+			SDL_CondWait(pool->wake, pool->lock);
+		}
+		if (pool->quit) break;
+
+		seen = pool->generation;
+		iso_thread_job* jobs = pool->jobs;
+		u32 cnt = pool->job_cnt;
+		pool->active++;
+		SDL_UnlockMutex(pool->lock);
+
+		u32 done = __iso_thread_pool_work(pool, jobs, cnt);
+
+		SDL_LockMutex(pool->lock);
+		pool->finished += done;
+		pool->active--;
+		if (pool->finished == pool->job_cnt || pool->active == 0) {
+			SDL_CondBroadcast(pool->done);
+		}
+	}
+	SDL_UnlockMutex(pool->lock);
+
+	return 0;
+}
+
+iso_thread_pool* iso_thread_pool_new(u32 thread_cnt) {
+	if (thread_cnt == 0) {
+		i32 cpu_cnt = SDL_GetCPUCount();
+		thread_cnt = cpu_cnt > 1 ? cpu_cnt - 1 : 0;
+	}
+	if (thread_cnt > ISO_THREAD_POOL_MAX_THREADS) thread_cnt = ISO_THREAD_POOL_MAX_THREADS;
+
+	iso_thread_pool* pool = iso_alloc(sizeof(iso_thread_pool));
+	pool->submit = SDL_CreateMutex();
+	pool->lock   = SDL_CreateMutex();
+	pool->wake   = SDL_CreateCond();
+	pool->done   = SDL_CreateCond();
+	iso_assert(pool->submit && pool->lock && pool->wake && pool->done, "Failed to create iso_thread_pool: %s\n", SDL_GetError());
+
+	// Indices are handed out before the threads start, every worker of the pool gets its own
+	for (u32 i = 0; i < thread_cnt; i++) {
+		pool->workers[i] = (iso_thread_worker) { pool, i + 1 };
+		pool->threads[i] = SDL_CreateThread(__iso_thread_pool_worker, "iso_worker", &pool->workers[i]);
+		iso_assert(pool->threads[i], "Failed to create worker thread: %s\n", SDL_GetError());
+	}
+	pool->thread_cnt = thread_cnt;
+
+	iso_log_info("Created iso_thread_pool with %u workers.\n", thread_cnt);
+	return pool;
+}
+
+void iso_thread_pool_delete(iso_thread_pool* pool) {
+	SDL_LockMutex(pool->lock);
+	pool->quit = true;
+	SDL_CondBroadcast(pool->wake);
+	SDL_UnlockMutex(pool->lock);
+
+	for (u32 i = 0; i < pool->thread_cnt; i++) {
+		SDL_WaitThread(pool->threads[i], NULL);
+	}
+
+	SDL_DestroyCond(pool->done);
+	SDL_DestroyCond(pool->wake);
+	SDL_DestroyMutex(pool->lock);
+	SDL_DestroyMutex(pool->submit);
+	iso_free(pool->range_jobs);
+	iso_free(pool);
+}
+
+/*
+ * @brief Hands a batch to the workers and waits for it, the caller holds `submit`
+ */
+
+static void __iso_thread_pool_submit(iso_thread_pool* pool, iso_thread_job* jobs, u32 cnt) {
+	SDL_LockMutex(pool->lock);
+
+	// Waiting for the workers that are still leaving the previous batch
+	while (pool->active) {
+		SDL_CondWait(pool->done, pool->lock);
+	}
+
+	pool->jobs     = jobs;
+	pool->job_cnt  = cnt;
+	pool->finished = 0;
+	SDL_AtomicSet(&pool->next, 0);
+	pool->generation++;
+	SDL_CondBroadcast(pool->wake);
+	SDL_UnlockMutex(pool->lock);
+
+	u32 done = __iso_thread_pool_work(pool, jobs, cnt);
+
+	SDL_LockMutex(pool->lock);
+	pool->finished += done;
+	while (pool->finished < cnt) {
+		SDL_CondWait(pool->done, pool->lock);
+	}
+	SDL_UnlockMutex(pool->lock);
+}
+
+void iso_thread_pool_run(iso_thread_pool* pool, iso_thread_job* jobs, u32 cnt) {
+	if (cnt == 0) return;
+
+	// Running inline when there is nobody to share the work with
+	if (pool == NULL || pool->thread_cnt == 0 || cnt == 1 || __iso_thread_pool_in_job) {
+		for (u32 i = 0; i < cnt; i++) {
+			jobs[i].fn(jobs[i].data, jobs[i].start, jobs[i].end);
+		}
+		return;
+	}
+
+	// The batch state is shared, other submitters wait for this batch to finish
+	SDL_LockMutex(pool->submit);
+	__iso_thread_pool_submit(pool, jobs, cnt);
+	SDL_UnlockMutex(pool->submit);
+}
+
+void iso_thread_pool_parallel_for(iso_thread_pool* pool, u32 cnt, u32 batch, iso_thread_job_fn fn, void* data) {
+	if (cnt == 0) return;
+
+	if (pool == NULL || pool->thread_cnt == 0 || __iso_thread_pool_in_job) {
+		fn(data, 0, cnt);
+		return;
+	}
+
+	if (batch == 0) {
+		u32 share = pool->thread_cnt + 1;
+		batch = (cnt + share - 1) / share;
+	}
+
+	u32 job_cnt = (cnt + batch - 1) / batch;
+	if (job_cnt == 1) {
+		fn(data, 0, cnt);
+		return;
+	}
+
+	// `range_jobs` belongs to the batch, so it is only touched while holding `submit`
+	SDL_LockMutex(pool->submit);
+	if (pool->range_cap < job_cnt) {
+		pool->range_cap  = job_cnt;
+		pool->range_jobs = iso_realloc(pool->range_jobs, sizeof(iso_thread_job) * job_cnt);
+	}
+
+	for (u32 i = 0; i < job_cnt; i++) {
+		u32 start = i * batch;
+		u32 end   = start + batch < cnt ? start + batch : cnt;
+		pool->range_jobs[i] = (iso_thread_job) { fn, data, start, end };
+	}
+
+	__iso_thread_pool_submit(pool, pool->range_jobs, job_cnt);
+	SDL_UnlockMutex(pool->submit);
+}
+
+u32 iso_thread_pool_worker_index() {
+	return __iso_thread_pool_worker_index;
+}
@@ -0,0 +1,138 @@
+#ifndef __ISO_THREAD_POOL_H__
+#define __ISO_THREAD_POOL_H__
+
+#include "iso_includes.h"
+#include "iso_defines.h"
+#include "iso_memory.h"
+
+// Max amount of worker threads of a pool
+#define ISO_THREAD_POOL_MAX_THREADS 64
+
+/*
+ * @brief Function run by a job
+ * @param data  = User data of the job
+ * @param start = Start of the range of the job (inclusive)
+ * @param end   = End of the range of the job (exclusive)
+ */
+
+typedef void (*iso_thread_job_fn)(void* data, u32 start, u32 end);
+
+/*
+ * @brief Single unit of work handed to the pool
+ * @mem fn    = Function to run
+ * @mem data  = User data passed to the function
+ * @mem start = Start of the range passed to the function
+ * @mem end   = End of the range passed to the function
+ */
+
+typedef struct {
+	iso_thread_job_fn fn;
+	void* data;
+	u32   start;
+	u32   end;
+} iso_thread_job;
+
+typedef struct iso_thread_pool iso_thread_pool;
+
+/*
+ * @brief Argument of a worker thread
+ * @mem pool  = Pool the worker belongs to
+ * @mem index = Index of the worker inside the pool (1..thread_cnt)
+ */
+
+typedef struct {
+	iso_thread_pool* pool;
+	u32              index;
+} iso_thread_worker;
+
+/*
+ * @brief Pool of worker threads. The thread that submits a batch of jobs
+ *        works on it too and returns once every job of the batch is done.
+ *        Batches submitted from different threads run one after the other,
+ *        batches submitted from inside a job run inline.
+ * @mem threads    = Worker threads
+ * @mem workers    = Arguments of the worker threads
+ * @mem thread_cnt = No of worker threads
+ * @mem submit     = Mutex held by the submitting thread for the whole batch
+ * @mem lock       = Mutex guarding the batch state
+ * @mem wake       = Signaled when a new batch is submitted
+ * @mem done       = Signaled when a batch is finished or a worker goes idle
+ * @mem jobs       = Jobs of the current batch
+ * @mem job_cnt    = No of jobs in the current batch
+ * @mem next       = Index of the next job to be claimed
+ * @mem finished   = No of finished jobs of the current batch
+ * @mem active     = No of workers working on the current batch
+ * @mem generation = Id of the current batch
+ * @mem quit       = Set when the pool is deleted
+ * @mem range_jobs = Storage of the jobs built by iso_thread_pool_parallel_for
+ * @mem range_cap  = Capacity of `range_jobs`
+ */
+
+struct iso_thread_pool {
+	SDL_Thread*       threads[ISO_THREAD_POOL_MAX_THREADS];
+	iso_thread_worker workers[ISO_THREAD_POOL_MAX_THREADS];
+	u32               thread_cnt;
+
+	SDL_mutex* submit;
+	SDL_mutex* lock;
+	SDL_cond*  wake;
+	SDL_cond*  done;
+
+	iso_thread_job* jobs;
+	u32             job_cnt;
+	SDL_atomic_t    next;
+	u32             finished;
+	u32             active;
+	u32             generation;
+	b8              quit;
+
+	iso_thread_job* range_jobs;
+	u32             range_cap;
+};
+
+
+/*
+ * @brief Function to create a thread pool
+ * @param thread_cnt = No of worker threads (0 to use one less than the cpu count)
+ * @return Returns pointer to the iso_thread_pool
+ */
+
+ISO_API iso_thread_pool* iso_thread_pool_new(u32 thread_cnt);
+
+/*
+ * @brief Function to stop the workers and delete the pool
+ * @param pool = Pointer to the iso_thread_pool
+ */
+
+ISO_API void iso_thread_pool_delete(iso_thread_pool* pool);
+
+/*
+ * @brief Function to run a batch of jobs and wait for all of them to finish.
+ *        With a NULL pool the jobs run on the calling thread.
+ * @param pool = Pointer to the iso_thread_pool
+ * @param jobs = Array of jobs
+ * @param cnt  = No of jobs
+ */
+
+ISO_API void iso_thread_pool_run(iso_thread_pool* pool, iso_thread_job* jobs, u32 cnt);
+
+/*
+ * @brief Function to split the range [0, cnt) in batches and run them across the pool
+ * @param pool  = Pointer to the iso_thread_pool (NULL runs the range on the calling thread)
+ * @param cnt   = Size of the range
+ * @param batch = Size of a batch (0 to split the range evenly between the threads)
+ * @param fn    = Function called with every batch
+ * @param data  = User data passed to the function
+ */
+
+ISO_API void iso_thread_pool_parallel_for(iso_thread_pool* pool, u32 cnt, u32 batch, iso_thread_job_fn fn, void* data);
+
+/*
+ * @brief Function to get the index of the calling thread inside its pool.
+ *        Useful to pick per-thread data from inside a job.
+ * @return Returns 0 for threads that are not workers and 1..thread_cnt for the workers
+ */
+
+ISO_API u32 iso_thread_pool_worker_index();
+
+#endif // __ISO_THREAD_POOL_H__
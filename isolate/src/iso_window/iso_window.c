@@ -4,6 +4,7 @@
 extern iso_app* app;
 
 iso_window* iso_window_new(iso_window_def window_def) {
+	iso_memory_push_tag(ISO_MEMORY_TAG_APP);
 	iso_log_info("Constructing iso_window...\n");
 
 	iso_window* window = iso_alloc(sizeof(iso_window));
@@ -30,6 +31,7 @@ iso_window* iso_window_new(iso_window_def window_def) {
 	));
 
 	iso_log_sucess("Created iso_window:\n\tTitle: `%s`\n\tRes: %dx%d\n", window->title, window->width, window->height);
+	iso_memory_pop_tag();
 	return window;
 }
 
@@ -3,6 +3,9 @@
 
 /* Iso utilities */
 #include "iso_util/iso_memory.h"
+#include "iso_util/iso_arena.h"
+#include "iso_util/iso_pool.h"
+#include "iso_util/iso_thread_pool.h"
 #include "iso_util/iso_defines.h"
 #include "iso_util/iso_log.h"
 #include "iso_util/iso_hash_map.h"